@@ -0,0 +1,272 @@
+// small benchmark harness for the JSON suites: timed samples, summary statistics, JSON results and a
+// comparison against a stored baseline run. Every suite takes the same options:
+//   --json <path>        write the results there
+//   --baseline <path>    compare with an earlier --json file, exit code 1 on regressions
+//   --threshold <ratio>  how much slower a benchmark may get before it counts as a regression, default 0.1.
+//                        Both the median and the minimum have to be past it, one noisy sample isn't enough.
+//   --filter <text>      only run benchmarks whose name contains text
+//   --samples <n>        samples per benchmark, default 15
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+// keeps the compiler from optimizing away a result nobody reads
+template<typename T>
+inline void doNotOptimize(const T &value){
+	asm volatile("" : : "r"(&value) : "memory");
+}
+
+struct Stats {
+	double minNs;
+	double medianNs;
+	double meanNs;
+	double stddevNs;
+	double p90Ns;
+	double maxNs;
+};
+
+inline Stats computeStats(std::vector<double> samples){
+	std::sort(samples.begin(), samples.end());
+	size_t count = samples.size();
+	double sum = 0.0;
+	for(double sample : samples){
+		sum += sample;
+	}
+	double mean = sum / count;
+	double variance = 0.0;
+	for(double sample : samples){
+		variance += (sample - mean) * (sample - mean);
+	}
+	double median = count % 2 ? samples[count / 2] : 0.5 * (samples[count / 2 - 1] + samples[count / 2]);
+	return {
+		samples.front(),
+		median,
+		mean,
+		count > 1 ? std::sqrt(variance / (count - 1)) : 0.0,
+		samples[std::min(count - 1, static_cast<size_t>(std::ceil(0.9 * count)) - 1)],
+		samples.back(),
+	};
+}
+
+struct Result {
+	std::string name;
+	uint32_t samples;
+	uint64_t iterations;	// calls per sample, the statistics are per call
+	double itemsPerCall;	// 0 if the benchmark has no natural item count
+	Stats stats;
+};
+
+class Suite {
+public:
+	// a sample runs the benchmark until at least this much time passed, short calls get batched
+	static constexpr double MIN_SAMPLE_MS = 10.0;
+
+	Suite(std::string name, int argc, char **argv) : name{std::move(name)}{
+		for(int i = 1; i < argc; i++){
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+			if(arg == "--json" && hasValue){
+				jsonPath = argv[++i];
+			}
+			else if(arg == "--baseline" && hasValue){
+				baselinePath = argv[++i];
+			}
+			else if(arg == "--threshold" && hasValue){
+				threshold = std::stod(argv[++i]);
+			}
+			else if(arg == "--filter" && hasValue){
+				filter = argv[++i];
+			}
+			else if(arg == "--samples" && hasValue){
+				sampleCount = std::max(1, std::atoi(argv[++i]));
+			}
+			else{
+				positional.push_back(arg);
+			}
+		}
+	}
+
+	// arguments that weren't harness options, in order
+	const std::vector<std::string> &getArguments() const { return positional; }
+	uint32_t getSampleCount() const { return sampleCount; }
+	bool isEnabled(const std::string &benchmark) const { return benchmark.find(filter) != std::string::npos; }
+
+	// times fn(), after one warm up call, as sampleCount samples of enough calls to fill MIN_SAMPLE_MS
+	template<typename Fn>
+	void run(const std::string &benchmark, Fn &&fn, double itemsPerCall = 0.0){
+		if(!isEnabled(benchmark)){
+			return;
+		}
+		auto start = Clock::now();
+		fn();
+		double warmupMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		uint64_t iterations = std::max<uint64_t>(1, static_cast<uint64_t>(MIN_SAMPLE_MS / std::max(warmupMs, 1e-6)));
+
+		std::vector<double> samples;
+		samples.reserve(sampleCount);
+		for(uint32_t sample = 0; sample < sampleCount; sample++){
+			start = Clock::now();
+			for(uint64_t i = 0; i < iterations; i++){
+				fn();
+			}
+			samples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations);
+		}
+		add(benchmark, samples, iterations, itemsPerCall);
+	}
+
+	// for benchmarks that time only part of what they run, samples are nanoseconds per call
+	void add(const std::string &benchmark, const std::vector<double> &samples, uint64_t iterations = 1, double itemsPerCall = 0.0){
+		if(samples.empty()){
+			return;
+		}
+		results.push_back({benchmark, static_cast<uint32_t>(samples.size()), iterations, itemsPerCall, computeStats(samples)});
+		auto &stats = results.back().stats;
+		printf("%-40s %12s  +- %5.1f%%  (min %s, %u x %llu)\n", benchmark.c_str(), formatTime(stats.medianNs).c_str(),
+			stats.medianNs > 0.0 ? 100.0 * stats.stddevNs / stats.medianNs : 0.0, formatTime(stats.minNs).c_str(),
+			results.back().samples, static_cast<unsigned long long>(iterations));
+		fflush(stdout);
+	}
+
+	// writes the JSON and compares with the baseline, returns the process exit code
+	int finish(){
+		if(!jsonPath.empty()){
+			writeJson();
+		}
+		return baselinePath.empty() ? EXIT_SUCCESS : compareBaseline();
+	}
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	std::string name;
+	std::string jsonPath;
+	std::string baselinePath;
+	double threshold = 0.1;
+	std::string filter;
+	uint32_t sampleCount = 15;
+	std::vector<std::string> positional;
+	std::vector<Result> results;
+
+	static std::string formatTime(double ns){
+		char text[32];
+		if(ns < 1e3){
+			snprintf(text, sizeof(text), "%.1f ns", ns);
+		}
+		else if(ns < 1e6){
+			snprintf(text, sizeof(text), "%.2f us", ns * 1e-3);
+		}
+		else if(ns < 1e9){
+			snprintf(text, sizeof(text), "%.2f ms", ns * 1e-6);
+		}
+		else{
+			snprintf(text, sizeof(text), "%.2f s", ns * 1e-9);
+		}
+		return text;
+	}
+
+	void writeJson(){
+		FILE *file = fopen(jsonPath.c_str(), "w");
+		if(file == nullptr){
+			throw std::runtime_error("Failed to open " + jsonPath);
+		}
+		fprintf(file, "{\n\"suite\": \"%s\",\n", name.c_str());
+		fprintf(file, "\"context\": {\"compiler\": \"%s\", \"hardware_concurrency\": %u, \"unix_time\": %lld},\n",
+#ifdef __VERSION__
+			__VERSION__,
+#else
+			"unknown",
+#endif
+			std::thread::hardware_concurrency(), static_cast<long long>(std::time(nullptr)));
+		// one benchmark per line, readBaseline relies on it
+		fprintf(file, "\"benchmarks\": [\n");
+		for(size_t i = 0; i < results.size(); i++){
+			auto &result = results[i];
+			auto &stats = result.stats;
+			fprintf(file, "{\"name\": \"%s\", \"samples\": %u, \"iterations\": %llu, \"median_ns\": %.3f, \"mean_ns\": %.3f, "
+				"\"stddev_ns\": %.3f, \"min_ns\": %.3f, \"p90_ns\": %.3f, \"max_ns\": %.3f",
+				result.name.c_str(), result.samples, static_cast<unsigned long long>(result.iterations),
+				stats.medianNs, stats.meanNs, stats.stddevNs, stats.minNs, stats.p90Ns, stats.maxNs);
+			if(result.itemsPerCall > 0.0 && stats.medianNs > 0.0){
+				fprintf(file, ", \"items_per_second\": %.1f", result.itemsPerCall * 1e9 / stats.medianNs);
+			}
+			fprintf(file, "}%s\n", i + 1 < results.size() ? "," : "");
+		}
+		fprintf(file, "]\n}\n");
+		if(fclose(file) != 0){
+			throw std::runtime_error("Failed to write " + jsonPath);
+		}
+		printf("results written to %s\n", jsonPath.c_str());
+	}
+
+	struct BaselineEntry {
+		double medianNs;
+		double minNs;
+	};
+
+	// only understands files written by writeJson
+	std::map<std::string, BaselineEntry> readBaseline(){
+		std::map<std::string, BaselineEntry> entries;
+		std::ifstream file{baselinePath};
+		std::string line;
+		while(std::getline(file, line)){
+			size_t nameStart = line.find("{\"name\": \"");
+			size_t medianStart = line.find("\"median_ns\": ");
+			size_t minStart = line.find("\"min_ns\": ");
+			if(nameStart == std::string::npos || medianStart == std::string::npos || minStart == std::string::npos){
+				continue;
+			}
+			nameStart += 10;
+			size_t nameEnd = line.find('"', nameStart);
+			entries[line.substr(nameStart, nameEnd - nameStart)] = {
+				std::atof(line.c_str() + medianStart + 13),
+				std::atof(line.c_str() + minStart + 10),
+			};
+		}
+		return entries;
+	}
+
+	int compareBaseline(){
+		auto baseline = readBaseline();
+		if(baseline.empty()){
+			printf("no baseline in %s, record one with --json\n", baselinePath.c_str());
+			return EXIT_SUCCESS;
+		}
+
+		printf("\n%-40s %12s %12s %8s\n", "compared to baseline", "median", "baseline", "change");
+		int regressions = 0;
+		for(auto &result : results){
+			auto it = baseline.find(result.name);
+			if(it == baseline.end() || it->second.medianNs <= 0.0 || it->second.minNs <= 0.0){
+				printf("%-40s %12s %12s %8s\n", result.name.c_str(), formatTime(result.stats.medianNs).c_str(), "-", "new");
+				continue;
+			}
+			double change = result.stats.medianNs / it->second.medianNs - 1.0;
+			bool regressed = change > threshold && result.stats.minNs / it->second.minNs - 1.0 > threshold;
+			regressions += regressed;
+			printf("%-40s %12s %12s %+7.1f%%%s\n", result.name.c_str(), formatTime(result.stats.medianNs).c_str(),
+				formatTime(it->second.medianNs).c_str(), 100.0 * change, regressed ? "  REGRESSION" : "");
+		}
+		if(regressions > 0){
+			printf("%d benchmark%s more than %.0f%% slower than %s\n", regressions, regressions == 1 ? "" : "s", 100.0 * threshold, baselinePath.c_str());
+			return EXIT_FAILURE;
+		}
+		return EXIT_SUCCESS;
+	}
+};
+
+}
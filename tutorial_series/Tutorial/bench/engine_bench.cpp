@@ -0,0 +1,92 @@
+// CPU hot paths that need no GPU: Sierpinski generation, vertex indexing and object transforms
+// usage: engine_bench.out [harness options, see bench.hpp]
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "../lve_game_object.hpp"
+#include "../lve_job_system.hpp"
+#include "../lve_model.hpp"
+#include "../lve_sierpinski.hpp"
+#include "../lve_transform_batch.hpp"
+#include "bench.hpp"
+
+using namespace lve;
+
+// the demo's triangle
+const std::vector<LveModel::Vertex> TRIANGLE = {
+	{{ 0.00f, -0.75f},{1.0f, 0.0f, 0.0f}},
+	{{ 0.75f,  0.75f},{0.0f, 1.0f, 0.0f}},
+	{{-0.75f,  0.75f},{0.0f, 0.0f, 1.0f}}
+};
+
+int main(int argc, char **argv){
+	bench::Suite suite{"engine", argc, argv};
+	LveJobSystem jobSystem;
+
+	// into one preallocated buffer, like streaming into a mapped vertex buffer
+	for(uint32_t depth : {6u, 8u, 10u, 12u}){
+		std::vector<LveModel::Vertex> vertices(getSierpinskiVertexCount(TRIANGLE.size(), depth));
+		if(depth <= 10){
+			suite.run("sierpinski/depth " + std::to_string(depth), [&]{
+				generateSierpinski(TRIANGLE.data(), TRIANGLE.size(), depth, vertices.data());
+				bench::doNotOptimize(vertices.data());
+			}, static_cast<double>(vertices.size()));
+		}
+		suite.run("sierpinski parallel/depth " + std::to_string(depth), [&]{
+			generateSierpinski(TRIANGLE.data(), TRIANGLE.size(), depth, vertices.data(), &jobSystem);
+			bench::doNotOptimize(vertices.data());
+		}, static_cast<double>(vertices.size()));
+	}
+
+	for(uint32_t depth : {6u, 8u}){
+		auto input = generateSierpinski(TRIANGLE, depth);
+		std::vector<LveModel::Vertex> vertices;
+		std::vector<uint32_t> indices;
+		suite.run("index vertices/depth " + std::to_string(depth), [&]{
+			vertices.clear();
+			indices.clear();
+			indexVertices(input, vertices, indices);
+			bench::doNotOptimize(indices.data());
+		}, static_cast<double>(input.size()));
+	}
+
+	// fixed seed so every run and the baseline see the same transforms
+	constexpr uint32_t TRANSFORM_COUNT = 1 << 16;
+	std::mt19937 rng{1234};
+	std::uniform_real_distribution<float> scaleDist{0.1f, 4.0f};
+	std::uniform_real_distribution<float> rotationDist{0.0f, glm::two_pi<float>()};
+	std::vector<glm::vec2> scales(TRANSFORM_COUNT);
+	std::vector<float> rotations(TRANSFORM_COUNT);
+	for(uint32_t i = 0; i < TRANSFORM_COUNT; i++){
+		scales[i] = {scaleDist(rng), scaleDist(rng)};
+		rotations[i] = rotationDist(rng);
+	}
+
+	std::vector<glm::mat2> matrices(TRANSFORM_COUNT);
+	suite.run("transform2dMatrix/65536", [&]{
+		for(uint32_t i = 0; i < TRANSFORM_COUNT; i++){
+			matrices[i] = transform2dMatrix(scales[i], rotations[i]);
+		}
+		bench::doNotOptimize(matrices.data());
+	}, TRANSFORM_COUNT);
+
+	std::vector<float> out(4 * TRANSFORM_COUNT);
+	for(LveSimdLevel level : {LveSimdLevel::Scalar, LveSimdLevel::Sse2, LveSimdLevel::Avx2, LveSimdLevel::Avx512}){
+		if(level > detectSimdLevel()){
+			continue;
+		}
+		suite.run(std::string("computeTransforms2d/") + getSimdLevelName(level) + "/65536", [&]{
+			computeTransforms2d(&scales[0].x, rotations.data(), TRANSFORM_COUNT, out.data(), level);
+			bench::doNotOptimize(out.data());
+		}, TRANSFORM_COUNT);
+	}
+
+	return suite.finish();
+}
@@ -0,0 +1,126 @@
+// headless frame loops over growing scenes: snapshot plus command recording alone, and whole frames
+// usage: frame_bench.out [harness options, see bench.hpp]
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include "../lve_device.hpp"
+#include "../lve_frame_info.hpp"
+#include "../lve_game_object.hpp"
+#include "../lve_job_system.hpp"
+#include "../lve_model.hpp"
+#include "../lve_renderer.hpp"
+#include "../lve_scene_snapshot.hpp"
+#include "../simple_render_system.hpp"
+#include "bench.hpp"
+
+using namespace lve;
+
+// frames timed together as one sample, keeps frames in flight overlapping like in the app
+constexpr int FRAMES_PER_SAMPLE = 10;
+
+int main(int argc, char **argv){
+	bench::Suite suite{"frame", argc, argv};
+
+	LveDevice device;
+	LveJobSystem jobSystem;
+
+	// a handful of models so the draw list has several instanced runs to split
+	std::vector<std::shared_ptr<LveModel>> models;
+	for(int i = 0; i < 16; i++){
+		float size = 0.01f + 0.002f * i;
+		std::vector<LveModel::Vertex> vertices = {
+			{{0.0f, -size}, {1.0f, 0.0f, 0.0f}},
+			{{size, size}, {0.0f, 1.0f, 0.0f}},
+			{{-size, size}, {0.0f, 0.0f, 1.0f}},
+		};
+		models.push_back(std::make_shared<LveModel>(device, vertices));
+	}
+
+	for(uint32_t objectCount : {1000u, 10000u, 100000u}){
+		std::string recordName = "record/" + std::to_string(objectCount);
+		std::string frameName = "frame/" + std::to_string(objectCount);
+		if(!suite.isEnabled(recordName) && !suite.isEnabled(frameName)){
+			continue;
+		}
+
+		LveGameObjectStore gameObjects;
+		gameObjects.reserve(objectCount);
+		for(uint32_t i = 0; i < objectCount; i++){
+			auto object = gameObjects.createGameObject(models[(i * 7) % models.size()]);
+			object.color() = {(i % 3) / 2.0f, (i % 5) / 4.0f, (i % 7) / 6.0f};
+			object.translation() = {(i % 317) / 158.0f - 1.0f, (i / 317 % 317) / 158.0f - 1.0f};
+			object.rotation() = 0.001f * i;
+		}
+
+		LveRenderer renderer{device, {800, 600}, &jobSystem};
+		SimpleRenderSystem renderSystem{device, renderer.getSwapChainRenderPass()};
+		LveSceneBuffer sceneBuffer;
+
+		// one simulation step, snapshot and recorded frame, returns the nanoseconds spent snapshotting and recording
+		auto frame = [&](uint32_t movingCount){
+			gameObjects.savePreviousState();
+			float *rotations = gameObjects.rotations();
+			for(uint32_t i = 0; i < movingCount; i++){
+				rotations[i] += 0.01f;
+				gameObjects.markChanged(i);
+			}
+
+			auto commandBuffer = renderer.beginFrame();
+			FrameInfo frameInfo{
+				.frameIndex = renderer.getFrameIndex(),
+				.commandBuffer = commandBuffer,
+				.parallelRecorder = renderer.getParallelRecorder(),
+			};
+			renderer.beginSwapChainRenderPass(commandBuffer);
+			auto start = std::chrono::steady_clock::now();
+			sceneBuffer.publish(gameObjects, start);
+			sceneBuffer.acquire();
+			renderSystem.renderGameObjects(frameInfo, sceneBuffer.getSnapshot());
+			auto end = std::chrono::steady_clock::now();
+			renderer.endSwapChainRenderPass(commandBuffer);
+			renderer.endFrame();
+			return std::chrono::duration<double, std::nano>(end - start).count();
+		};
+
+		// the first frames grow instance buffers and command pools, leave them out
+		for(int i = 0; i < 10; i++){
+			frame(objectCount);
+		}
+
+		if(suite.isEnabled(recordName)){
+			// most objects in a scene sit still, only the moving ones get their instances rewritten
+			std::vector<double> samples;
+			for(uint32_t sample = 0; sample < suite.getSampleCount(); sample++){
+				double totalNs = 0.0;
+				for(int i = 0; i < FRAMES_PER_SAMPLE; i++){
+					totalNs += frame(objectCount / 10);
+				}
+				samples.push_back(totalNs / FRAMES_PER_SAMPLE);
+			}
+			suite.add(recordName, samples, FRAMES_PER_SAMPLE, objectCount);
+		}
+
+		if(suite.isEnabled(frameName)){
+			std::vector<double> samples;
+			for(uint32_t sample = 0; sample < suite.getSampleCount(); sample++){
+				auto start = std::chrono::steady_clock::now();
+				for(int i = 0; i < FRAMES_PER_SAMPLE; i++){
+					frame(objectCount);
+				}
+				samples.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / FRAMES_PER_SAMPLE);
+			}
+			suite.add(frameName, samples, FRAMES_PER_SAMPLE, objectCount);
+		}
+
+		vkDeviceWaitIdle(device.device());
+	}
+
+	return suite.finish();
+}
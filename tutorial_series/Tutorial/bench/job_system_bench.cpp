@@ -0,0 +1,109 @@
+// micro benchmarks of LveJobSystem: spawn overhead, fan-out/fan-in latency, parallelFor scaling
+// usage: job_system_bench.out [max threads]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "../lve_job_system.hpp"
+
+using lve::LveJobSystem;
+
+template<typename Fn>
+double timedMs(Fn fn){
+	auto start = std::chrono::steady_clock::now();
+	fn();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// best of a few runs, the first one pays for waking the workers up
+template<typename Fn>
+double bestMs(int runs, Fn fn){
+	double best = timedMs(fn);
+	for(int i = 1; i < runs; i++){
+		best = std::min(best, timedMs(fn));
+	}
+	return best;
+}
+
+void noop(void*, uint32_t){}
+
+int main(int argc, char **argv){
+	uint32_t maxThreads = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : std::max(1u, std::thread::hardware_concurrency());
+	bool ok = true;
+
+	printf("%-8s %14s %14s %14s %12s %8s\n", "threads", "spawn ns/job", "fan-out us", "nested us", "for ms", "speedup");
+	double serialForMs = 0.0;
+	for(uint32_t threads = 1; threads <= maxThreads; threads *= 2){
+		LveJobSystem jobSystem{threads};
+
+		// spawn overhead: submit and join many empty jobs from one thread
+		constexpr uint32_t SPAWN_JOBS = 100000;
+		double spawnMs = bestMs(5, [&]{
+			LveJobSystem::Counter counter;
+			for(uint32_t i = 0; i < SPAWN_JOBS; i++){
+				jobSystem.submit(counter, noop, nullptr, i);
+			}
+			jobSystem.wait(counter);
+		});
+
+		// fan-out/fan-in latency: one tiny job per thread, joined right away
+		constexpr int FAN_ROUNDS = 1000;
+		std::atomic<uint32_t> touched{0};
+		double fanMs = bestMs(5, [&]{
+			for(int round = 0; round < FAN_ROUNDS; round++){
+				LveJobSystem::Counter counter;
+				for(uint32_t i = 0; i < threads; i++){
+					jobSystem.submit(counter, [](void *data, uint32_t){
+						static_cast<std::atomic<uint32_t>*>(data)->fetch_add(1, std::memory_order_relaxed);
+					}, &touched);
+				}
+				jobSystem.wait(counter);
+			}
+		});
+		ok = ok && touched.load() == 5u * FAN_ROUNDS * threads;
+
+		// nested: every job fans out again and waits from inside a worker
+		std::atomic<uint32_t> leaves{0};
+		double nestedMs = bestMs(5, [&]{
+			for(int round = 0; round < FAN_ROUNDS / 10; round++){
+				jobSystem.parallelFor(threads * 4, 1, [&](uint32_t, uint32_t){
+					jobSystem.parallelFor(8, 1, [&](uint32_t, uint32_t){
+						leaves.fetch_add(1, std::memory_order_relaxed);
+					});
+				});
+			}
+		});
+		ok = ok && leaves.load() == 5u * (FAN_ROUNDS / 10) * threads * 4 * 8;
+
+		// throughput: a compute bound loop split with parallelFor
+		constexpr uint32_t FOR_COUNT = 1 << 22;
+		std::vector<float> values(FOR_COUNT);
+		double forMs = bestMs(3, [&]{
+			jobSystem.parallelFor(FOR_COUNT, [&](uint32_t begin, uint32_t end){
+				for(uint32_t i = begin; i < end; i++){
+					values[i] = std::sqrt(float(i)) * std::sin(float(i) * 0.001f);
+				}
+			});
+		});
+		ok = ok && values[FOR_COUNT - 1] == std::sqrt(float(FOR_COUNT - 1)) * std::sin(float(FOR_COUNT - 1) * 0.001f);
+		if(threads == 1){
+			serialForMs = forMs;
+		}
+
+		printf("%-8u %14.1f %14.2f %14.2f %12.2f %7.2fx\n", threads,
+			spawnMs * 1e6 / SPAWN_JOBS,
+			fanMs * 1e3 / FAN_ROUNDS,
+			nestedMs * 1e3 / (FAN_ROUNDS / 10),
+			forMs,
+			serialForMs / forMs);
+	}
+
+	printf("%s\n", ok ? "all jobs ran" : "MISSING JOBS");
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
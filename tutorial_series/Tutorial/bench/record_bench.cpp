@@ -0,0 +1,113 @@
+// CPU time spent snapshotting the scene and in SimpleRenderSystem::renderGameObjects with 1 to N recording threads
+// usage: record_bench.out [object count] [frames per thread count] [percent of objects moving per frame]
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include "../lve_device.hpp"
+#include "../lve_frame_info.hpp"
+#include "../lve_game_object.hpp"
+#include "../lve_job_system.hpp"
+#include "../lve_model.hpp"
+#include "../lve_renderer.hpp"
+#include "../lve_scene_snapshot.hpp"
+#include "../lve_window.hpp"
+#include "../simple_render_system.hpp"
+
+using namespace lve;
+
+int main(int argc, char **argv){
+	uint32_t objectCount = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 100000;
+	int frames = argc > 2 ? atoi(argv[2]) : 200;
+	// most objects in a scene sit still, only the moving ones get their instances rewritten
+	uint32_t movingCount = static_cast<uint32_t>(uint64_t(objectCount) * (argc > 3 ? atoi(argv[3]) : 10) / 100);
+	uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	LveWindow window{800, 600, "record bench"};
+	LveDevice device{window};
+
+	// a handful of models so the draw list has several instanced runs to split
+	std::vector<std::shared_ptr<LveModel>> models;
+	for(int i = 0; i < 16; i++){
+		float size = 0.01f + 0.002f * i;
+		std::vector<LveModel::Vertex> vertices = {
+			{{0.0f, -size}, {1.0f, 0.0f, 0.0f}},
+			{{size, size}, {0.0f, 1.0f, 0.0f}},
+			{{-size, size}, {0.0f, 0.0f, 1.0f}},
+		};
+		models.push_back(std::make_shared<LveModel>(device, vertices));
+	}
+
+	LveGameObjectStore gameObjects;
+	gameObjects.reserve(objectCount);
+	for(uint32_t i = 0; i < objectCount; i++){
+		auto object = gameObjects.createGameObject(models[(i * 7) % models.size()]);
+		object.color() = {(i % 3) / 2.0f, (i % 5) / 4.0f, (i % 7) / 6.0f};
+		object.translation() = {(i % 317) / 158.0f - 1.0f, (i / 317 % 317) / 158.0f - 1.0f};
+		object.rotation() = 0.001f * i;
+	}
+
+	printf("%u objects, %u moving, %d frames per run\n", objectCount, movingCount, frames);
+	double baselineMs = 0.0;
+	for(uint32_t threads = 1; threads <= maxThreads; threads++){
+		LveJobSystem jobSystem{threads};
+		LveRenderer renderer{window, device, &jobSystem};
+		SimpleRenderSystem renderSystem{device, renderer.getSwapChainRenderPass()};
+		LveSceneBuffer sceneBuffer;
+
+		double totalMs = 0.0;
+		int measured = 0;
+		// the first frames grow instance buffers and command pools, leave them out
+		for(int frame = -10; frame < frames && !window.shouldClose(); frame++){
+			glfwPollEvents();
+			auto commandBuffer = renderer.beginFrame();
+			if(!commandBuffer){
+				continue;
+			}
+			FrameInfo frameInfo{
+				.frameIndex = renderer.getFrameIndex(),
+				.commandBuffer = commandBuffer,
+				.parallelRecorder = renderer.getParallelRecorder(),
+			};
+
+			renderer.beginSwapChainRenderPass(commandBuffer);
+			auto start = std::chrono::steady_clock::now();
+			gameObjects.savePreviousState();
+			float *rotations = gameObjects.rotations();
+			for(uint32_t i = 0; i < movingCount; i++){
+				rotations[i] += 0.01f;
+				gameObjects.markChanged(i);
+			}
+			sceneBuffer.publish(gameObjects, start);
+			sceneBuffer.acquire();
+			renderSystem.renderGameObjects(frameInfo, sceneBuffer.getSnapshot());
+			auto end = std::chrono::steady_clock::now();
+			renderer.endSwapChainRenderPass(commandBuffer);
+			renderer.endFrame();
+
+			if(frame >= 0){
+				totalMs += std::chrono::duration<double, std::milli>(end - start).count();
+				measured++;
+			}
+		}
+		vkDeviceWaitIdle(device.device());
+
+		double frameMs = measured > 0 ? totalMs / measured : 0.0;
+		if(threads == 1){
+			baselineMs = frameMs;
+		}
+		printf("%2u threads   %8.3f ms/frame  %5.2fx\n", threads, frameMs, frameMs > 0.0 ? baselineMs / frameMs : 0.0);
+	}
+
+	return EXIT_SUCCESS;
+}
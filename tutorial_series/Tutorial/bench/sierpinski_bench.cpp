@@ -0,0 +1,73 @@
+// checks the compute shader Sierpinski generator against the CPU reference, then times both into a vertex buffer
+// usage: sierpinski_bench.out [harness options, see bench.hpp], needs shaders/sierpinski.comp.spv, runs on lavapipe
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include "../lve_device.hpp"
+#include "../lve_job_system.hpp"
+#include "../lve_model.hpp"
+#include "../lve_sierpinski.hpp"
+#include "../lve_sierpinski_compute.hpp"
+#include "bench.hpp"
+
+using namespace lve;
+
+// both paths do the same float math, anything above this is a real difference
+constexpr float MAX_ERROR = 1e-6f;
+
+int main(int argc, char **argv){
+	bench::Suite suite{"sierpinski", argc, argv};
+
+	LveDevice device;
+	LveJobSystem jobSystem;
+	LveSierpinskiCompute sierpinskiCompute{device};
+
+	// two triangles so the shader has to find each output's source triangle too
+	const std::vector<LveModel::Vertex> triangles = {
+		{{ 0.00f, -0.75f},{1.0f, 0.0f, 0.0f}},
+		{{ 0.75f,  0.75f},{0.0f, 1.0f, 0.0f}},
+		{{-0.75f,  0.75f},{0.0f, 0.0f, 1.0f}},
+		{{-0.90f, -0.90f},{1.0f, 1.0f, 0.0f}},
+		{{-0.10f, -0.90f},{0.0f, 1.0f, 1.0f}},
+		{{-0.50f, -0.10f},{1.0f, 0.0f, 1.0f}}
+	};
+
+	bool valid = true;
+	for(uint32_t depth = 0; depth <= 10; depth++){
+		float error = sierpinskiCompute.validate(triangles, depth);
+		if(error > MAX_ERROR){
+			printf("depth %u: GPU differs from the CPU reference by up to %g\n", depth, error);
+			valid = false;
+		}
+	}
+	if(!valid){
+		return EXIT_FAILURE;
+	}
+	printf("GPU matches the CPU reference for depths 0 to 10\n");
+
+	// CPU generation plus the upload it needs, against generating in place
+	for(uint32_t depth : {8u, 10u, 12u}){
+		double vertexCount = static_cast<double>(getSierpinskiVertexCount(triangles.size(), depth));
+		suite.run("cpu/depth " + std::to_string(depth), [&]{
+			auto vertices = generateSierpinski(triangles, depth, &jobSystem);
+			LveModel model{device, vertices};
+			// staged uploads finish asynchronously, count them and don't free the buffer under them
+			device.uploadContext().waitIdle();
+			bench::doNotOptimize(model);
+		}, vertexCount);
+		suite.run("gpu/depth " + std::to_string(depth), [&]{
+			auto model = sierpinskiCompute.generate(triangles, depth);
+			bench::doNotOptimize(model);
+		}, vertexCount);
+	}
+
+	return suite.finish();
+}
@@ -0,0 +1,109 @@
+// accuracy and throughput of the batched transform kernels against a double precision reference
+// usage: transform_bench.out [transform count]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "../lve_transform_batch.hpp"
+
+using lve::LveSimdLevel;
+
+template<typename Fn>
+double bestMs(int runs, Fn fn){
+	double best = 1e30;
+	for(int i = 0; i < runs; i++){
+		auto start = std::chrono::steady_clock::now();
+		fn();
+		best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+	return best;
+}
+
+// largest absolute difference from the reference, relative to the scale so big objects don't dominate
+double maxError(const std::vector<float> &scales, const std::vector<float> &rotations, const std::vector<float> &out){
+	double worst = 0.0;
+	for(size_t i = 0; i < rotations.size(); i++){
+		double s = std::sin(double(rotations[i]));
+		double c = std::cos(double(rotations[i]));
+		double sx = scales[2 * i];
+		double sy = scales[2 * i + 1];
+		const double expected[4] = {c * sx, s * sx, -s * sy, c * sy};
+		const double scale[4] = {sx, sx, sy, sy};
+		for(int k = 0; k < 4; k++){
+			worst = std::max(worst, std::abs(out[4 * i + k] - expected[k]) / std::abs(scale[k]));
+		}
+	}
+	return worst;
+}
+
+int main(int argc, char **argv){
+	// odd count so every kernel goes through its scalar tail
+	uint32_t count = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : (1u << 20) + 13;
+	bool ok = true;
+
+	std::mt19937 rng{1234};
+	std::uniform_real_distribution<float> scaleDist{0.01f, 4.0f};
+	std::vector<float> scales(2 * count);
+	for(float &scale : scales){
+		scale = scaleDist(rng) * (rng() & 1 ? 1.0f : -1.0f);
+	}
+
+	// angles objects actually have, and ones that kept spinning for a long time
+	struct Range { const char *name; float min; float max; double bound; };
+	const Range ranges[] = {
+		{"[0, 2pi)", 0.0f, 6.2831853f, 1e-6},
+		{"[-8192, 8192]", -8192.0f, 8192.0f, 1e-6},
+		{"[-1e5, 1e5]", -1e5f, 1e5f, 1e-5},
+	};
+
+	std::vector<LveSimdLevel> levels{LveSimdLevel::Scalar};
+	for(LveSimdLevel level : {LveSimdLevel::Sse2, LveSimdLevel::Avx2, LveSimdLevel::Avx512}){
+		if(level <= lve::detectSimdLevel()){
+			levels.push_back(level);
+		}
+	}
+	printf("dispatching to %s\n", lve::getSimdLevelName(lve::detectSimdLevel()));
+
+	std::vector<float> rotations(count);
+	std::vector<float> reference(4 * count);
+	std::vector<float> out(4 * count);
+	for(const Range &range : ranges){
+		std::uniform_real_distribution<float> rotationDist{range.min, range.max};
+		for(float &rotation : rotations){
+			rotation = rotationDist(rng);
+		}
+		printf("\nrotations in %s, %u transforms\n", range.name, count);
+		printf("%-8s %12s %12s %10s %8s\n", "level", "max error", "ms", "ns/xform", "speedup");
+
+		double scalarMs = 0.0;
+		for(LveSimdLevel level : levels){
+			std::fill(out.begin(), out.end(), 0.0f);
+			double ms = bestMs(5, [&]{
+				lve::computeTransforms2d(scales.data(), rotations.data(), count, out.data(), level);
+			});
+			double error = maxError(scales, rotations, out);
+			ok = ok && error <= range.bound;
+
+			// every level runs the same polynomial, only fma rounding can tell them apart
+			if(level == LveSimdLevel::Scalar){
+				scalarMs = ms;
+				reference = out;
+			}
+			else{
+				for(size_t i = 0; i < out.size(); i++){
+					ok = ok && std::abs(out[i] - reference[i]) <= range.bound * std::abs(scales[i / 4 * 2 + i % 4 / 2]);
+				}
+			}
+
+			printf("%-8s %12.3g %12.3f %10.3f %7.2fx\n", lve::getSimdLevelName(level), error, ms, ms * 1e6 / count, scalarMs / ms);
+		}
+	}
+
+	printf("\n%s\n", ok ? "all kernels within bounds" : "KERNEL ERROR OUT OF BOUNDS");
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
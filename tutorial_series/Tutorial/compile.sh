@@ -1,4 +1,5 @@
 #!/usr/bin/env bash
 
 glslc shaders/simple_shader.vert -o shaders/simple_shader.vert.spv
-glslc shaders/simple_shader.frag -o shaders/simple_shader.frag.spv
\ No newline at end of file
+glslc shaders/simple_shader.frag -o shaders/simple_shader.frag.spv
+glslc shaders/sierpinski.comp -o shaders/sierpinski.comp.spv
\ No newline at end of file
@@ -1,19 +1,29 @@
 #include "first_app.hpp"
+#include "lve_frame_info.hpp"
 #include "lve_game_object.hpp"
 #include "lve_model.hpp"
 #include "lve_pipeline.hpp"
+#include "lve_profiler.hpp"
+#include "lve_scene_snapshot.hpp"
+#include "lve_sierpinski.hpp"
+#include "lve_sierpinski_compute.hpp"
 #include "lve_swap_chain.hpp"
 #include "simple_render_system.hpp"
 #include <GLFW/glfw3.h>
 #include <algorithm>
-#include <array>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <iostream>
 #include <glm/common.hpp>
 #include <glm/fwd.hpp>
 #include <memory>
 #include <stdexcept>
+#include <thread>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 #define GLM_FORCE_RADIANS
@@ -23,65 +33,193 @@
 
 namespace lve {
 
-FirstApp::FirstApp(){
+FirstApp::FirstApp(const FirstAppOptions &options) : options{options},
+	lveWindow{options.headless ? nullptr : std::make_unique<LveWindow>(WIDTH, HEIGHT, "Hello Vulkan!")},
+	// neither is movable, guaranteed copy elision lets the condition pick the constructor
+	lveDevice{lveWindow ? LveDevice{*lveWindow} : LveDevice{}},
+	lveRenderer{lveWindow ? LveRenderer{*lveWindow, lveDevice, &jobSystem} : LveRenderer{lveDevice, {WIDTH, HEIGHT}, &jobSystem}}{
 	loadGameObjects();
+	gameObjects.savePreviousState();
 }
 
 FirstApp::~FirstApp(){
 }
 
 void FirstApp::run(){
+	LVE_PROFILE_THREAD("main");
+	// zones are always recorded into the ring buffers while tracing, the file only gets written on hitches and at exit
+	if(!options.tracePath.empty()){
+		LveProfiler::startCapture();
+	}
 	SimpleRenderSystem simpleRenderSystem{lveDevice, lveRenderer.getSwapChainRenderPass()};
 
-	// run until window terminated
-	while (!lveWindow.shouldClose()) {
-		// get glfw window events
-		glfwPollEvents();
-		if(auto commandBuffer = lveRenderer.beginFrame()){
-			lveRenderer.beginSwapChainRenderPass(commandBuffer);
-			simpleRenderSystem.renderGameObjects(commandBuffer, gameObjects);
-			lveRenderer.endSwapChainRenderPass(commandBuffer);
-			lveRenderer.endFrame();
+	// the simulation advances in fixed steps however fast frames come, rendering blends the last two
+	auto currentTime = std::chrono::steady_clock::now();
+	float accumulator = 0.0f;
+	sceneBuffer.publish(gameObjects, currentTime);
+	auto runStart = currentTime;
+	auto frameLimitReached = [&]{
+		return options.frameCount > 0 && renderedFrames.load() >= options.frameCount;
+	};
+
+	// from here on the render thread owns the renderer and the render system, it only sees snapshots of the scene
+	std::atomic<bool> stopRendering{false};
+	std::exception_ptr renderError;
+	std::thread renderThread;
+	// stops and joins the render thread however run is left, destroying a joinable std::thread terminates
+	struct RenderThreadGuard {
+		std::thread &thread;
+		std::atomic<bool> &stop;
+		~RenderThreadGuard(){
+			stop = true;
+			if(thread.joinable()){
+				thread.join();
+			}
 		}
+	} renderThreadGuard{renderThread, stopRendering};
+	if(options.renderThread){
+		renderThread = std::thread([&]{
+			LVE_PROFILE_THREAD("render");
+			try{
+				while(!stopRendering.load() && !frameLimitReached()){
+					renderFrame(simpleRenderSystem);
+				}
+			}
+			catch(...){
+				renderError = std::current_exception();
+				stopRendering = true;
+			}
+		});
+	}
+
+	// run until window terminated or enough frames were rendered
+	while (!(lveWindow && lveWindow->shouldClose()) && !stopRendering.load() && !frameLimitReached()) {
+		// get glfw window events, with a render thread there is nothing else to do until the next step
+		if(!lveWindow){
+			// no events without a window, frames are rendered back to back
+			if(options.renderThread){
+				std::this_thread::sleep_for(std::chrono::duration<float>(std::max(FIXED_TIMESTEP - accumulator, 0.0f)));
+			}
+		}
+		else if(options.renderThread){
+			LVE_PROFILE_ZONE("wait events");
+			glfwWaitEventsTimeout(std::max(FIXED_TIMESTEP - accumulator, 0.0f));
+		}
+		else{
+			LVE_PROFILE_ZONE("poll events");
+			glfwPollEvents();
+		}
+
+		auto newTime = std::chrono::steady_clock::now();
+		float frameTime = std::chrono::duration<float>(newTime - currentTime).count();
+		currentTime = newTime;
+		// after a long stall let the simulation fall behind instead of spiralling into catch up steps
+		accumulator += std::min(frameTime, MAX_FRAME_TIME);
+		bool stepped = false;
+		while(accumulator >= FIXED_TIMESTEP){
+			LVE_PROFILE_ZONE("simulation step");
+			gameObjects.savePreviousState();
+			update(FIXED_TIMESTEP);
+			accumulator -= FIXED_TIMESTEP;
+			stepped = true;
+		}
+
+		// the state just computed belongs to `accumulator` seconds ago
+		if(stepped){
+			LVE_PROFILE_ZONE("publish snapshot");
+			auto stepTime = newTime - std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(accumulator));
+			sceneBuffer.publish(gameObjects, stepTime);
+		}
+		if(!options.renderThread){
+			renderFrame(simpleRenderSystem);
+		}
+	}
+
+	stopRendering = true;
+	if(renderThread.joinable()){
+		renderThread.join();
 	}
 	// wait for GPU cleanup
 	vkDeviceWaitIdle(lveDevice.device());
-}
-
-LveModel::Vertex getMidpoint(LveModel::Vertex a, LveModel::Vertex b){
-	return {
-		{
-			(a.position.x + b.position.x)/2, 
-			(a.position.y + b.position.y)/2
-		},
-		{
-			(a.color.r+b.color.r)/2,
-			(a.color.g+b.color.g)/2,
-			(a.color.b+b.color.b)/2
+	if(options.frameCount > 0){
+		// counts until the GPU finished the last frame, not just until it was submitted
+		float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - runStart).count();
+		uint32_t frames = renderedFrames.load();
+		printf("%u frames in %.3f s, %.1f fps, %.3f ms per frame\n", frames, seconds, frames / seconds, 1000.0f * seconds / std::max(frames, 1u));
+	}
+	if(!options.tracePath.empty()){
+		LveProfiler::stopCapture();
+		LveProfiler::writeChromeTrace(options.tracePath);
+	}
+	if(renderError){
+		std::rethrow_exception(renderError);
+	}
+	if(!options.outputPath.empty()){
+		if(lveRenderer.getOffscreenTarget() == nullptr){
+			throw std::runtime_error("Writing the last frame needs headless mode");
 		}
-	};
+		lveRenderer.getOffscreenTarget()->writeLatestImage(options.outputPath);
+	}
 }
 
-std::vector<LveModel::Vertex> subdivide(std::vector<LveModel::Vertex> original){
-	LveModel::Vertex Ap = getMidpoint(original[0], original[1]);
-	LveModel::Vertex Bp = getMidpoint(original[1], original[2]);
-	LveModel::Vertex Cp = getMidpoint(original[2], original[0]);
+void FirstApp::renderFrame(SimpleRenderSystem &simpleRenderSystem){
+	auto frameStart = std::chrono::steady_clock::now();
+	LVE_PROFILE_ZONE("render frame");
+	sceneBuffer.acquire();
+	auto &scene = sceneBuffer.getSnapshot();
 
-	return {original[0],Ap,Cp, Cp,Bp,original[2], Ap,original[1],Bp};
-}
+	if(auto commandBuffer = lveRenderer.beginFrame()){
+		// blend from the previous step towards the current one as real time catches up with it
+		float interpolation = std::chrono::duration<float>(std::chrono::steady_clock::now() - scene.getStepTime()).count() / FIXED_TIMESTEP;
+		FrameInfo frameInfo{
+			.frameIndex = lveRenderer.getFrameIndex(),
+			.commandBuffer = commandBuffer,
+			.parallelRecorder = lveRenderer.getParallelRecorder(),
+			.interpolation = std::clamp(interpolation, 0.0f, 1.0f),
+			.gpuProfiler = lveRenderer.getGpuProfiler(),
+		};
 
-std::vector<LveModel::Vertex> generateSierpinski(const std::vector<LveModel::Vertex> &original){
-	std::vector<LveModel::Vertex> out(original.size()*3);
+		lveRenderer.beginSwapChainRenderPass(commandBuffer);
+		simpleRenderSystem.renderGameObjects(frameInfo, scene);
+		lveRenderer.endSwapChainRenderPass(commandBuffer);
+		lveRenderer.endFrame();
+		renderedFrames++;
+	}
 
-	for(size_t i=0; i<original.size()/3; i++){
-		std::vector<LveModel::Vertex> old_triangle = { original[i*3], original[i*3+1], original[i*3+2]};
-		auto new_triangle = subdivide(old_triangle);
-		for(size_t j=0; j<new_triangle.size(); j++){
-			out[i*9+j] = new_triangle[j];
-		}
+	if(options.gpuProfile && std::chrono::steady_clock::now() - lastProfilePrint > std::chrono::seconds(5)){
+		printGpuProfile();
+		lastProfilePrint = std::chrono::steady_clock::now();
+	}
+
+	// dump the ring buffers right after a slow frame while it is still in them, at most every few seconds
+	auto frameEnd = std::chrono::steady_clock::now();
+	float frameMs = std::chrono::duration<float, std::milli>(frameEnd - frameStart).count();
+	if(!options.tracePath.empty() && options.hitchMs > 0.0f && frameMs > options.hitchMs && frameEnd - lastTraceDump > std::chrono::seconds(5)){
+		printf("%.2f ms frame, writing %s\n", frameMs, options.tracePath.c_str());
+		LveProfiler::writeChromeTrace(options.tracePath);
+		lastTraceDump = std::chrono::steady_clock::now();
+	}
+}
+
+void FirstApp::printGpuProfile(){
+	auto gpuProfiler = lveRenderer.getGpuProfiler();
+	if(gpuProfiler == nullptr){
+		printf("gpu timestamps not supported\n");
+		return;
+	}
+	printf("%-32s %8s %8s %8s %8s\n", "gpu ms", "last", "min", "avg", "max");
+	for(auto &scope : gpuProfiler->getStats()){
+		int indent = 2 * static_cast<int>(scope.depth);
+		printf("%*s%-*s %8.3f %8.3f %8.3f %8.3f\n", indent, "", 32 - indent, scope.name.c_str(),
+			scope.lastMs, scope.minMs, scope.avgMs, scope.maxMs);
 	}
+}
 
-	return out;
+void FirstApp::update(float deltaTime){
+	// only the Sierpinski triangle spins, the background stays out of the change list and its instances aren't rewritten
+	constexpr float ROTATION_SPEED = 0.6f; // radians per second
+	float &rotation = spinningTriangle.rotation();
+	rotation = glm::mod(rotation + ROTATION_SPEED * deltaTime, glm::two_pi<float>());
 }
 
 void FirstApp::loadGameObjects(){
@@ -90,21 +228,44 @@ void FirstApp::loadGameObjects(){
 		{{ 0.75f,  0.75f},{0.0f, 1.0f, 0.0f}},
 		{{-0.75f,  0.75f},{0.0f, 0.0f, 1.0f}}
 	};
+	// the plain triangle, before the Sierpinski steps replace the vertices
+	auto backgroundModel = std::make_shared<LveModel>(lveDevice, verticies);
 
-	/*for(int i=0; i<9; i++){
-		verticies = generateSierpinski(verticies);
-	}*/
+	std::shared_ptr<LveModel> lveModel;
+	if(options.computeGeometry){
+		// the vertices are only ever written by the GPU, there is nothing to index or quantize
+		LveSierpinskiCompute sierpinskiCompute{lveDevice};
+		lveModel = sierpinskiCompute.generate(verticies, options.sierpinskiDepth);
+	}
+	else{
+		verticies = generateSierpinski(verticies, options.sierpinskiDepth, &jobSystem);
 
-	auto lveModel = std::make_shared<LveModel>(lveDevice, verticies);
+		std::vector<LveModel::Vertex> uniqueVertices;
+		std::vector<uint32_t> indices;
+		indexVertices(verticies, uniqueVertices, indices);
 
-	auto triangle = LveGameObject::createGameObject();
-	triangle.model = lveModel;
-	triangle.color = {.1f, .8f, .1f};
-	triangle.transform2d.translation.x = .2f;
-	triangle.transform2d.scale = {2.f, .5f};
-	triangle.transform2d.rotation = .25f * glm::two_pi<float>();
+		lveModel = std::make_shared<LveModel>(lveDevice, uniqueVertices, indices, LveModel::VertexLayout::Snorm16);
+		auto &error = lveModel->getQuantizationError();
+		std::cout << "model quantization error: position max " << error.maxPosition << " rms " << error.rmsPosition
+			<< ", color max " << error.maxColor << std::endl;
+	}
+
+	// a static grid of plain triangles behind it, most objects in a scene never move
+	constexpr int BACKGROUND_GRID = 10;
+	for(int y = 0; y < BACKGROUND_GRID; y++){
+		for(int x = 0; x < BACKGROUND_GRID; x++){
+			auto tile = gameObjects.createGameObject(backgroundModel);
+			tile.translation() = {-.9f + .2f * x, -.9f + .2f * y};
+			tile.scale() = {.08f, .08f};
+			tile.color() = {.1f, .1f + .03f * y, .2f + .03f * x};
+		}
+	}
 
-	gameObjects.push_back(std::move(triangle));
+	spinningTriangle = gameObjects.createGameObject(lveModel);
+	spinningTriangle.color() = {.1f, .8f, .1f};
+	spinningTriangle.translation().x = .2f;
+	spinningTriangle.scale() = {2.f, .5f};
+	spinningTriangle.rotation() = .25f * glm::two_pi<float>();
 
 }
 
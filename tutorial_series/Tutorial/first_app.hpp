@@ -1,23 +1,55 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
 #include "lve_window.hpp"
 #include "lve_device.hpp"
 #include "lve_game_object.hpp"
+#include "lve_job_system.hpp"
 #include "lve_renderer.hpp"
+#include "lve_scene_snapshot.hpp"
+#include "simple_render_system.hpp"
 
 namespace lve {
+
+struct FirstAppOptions {
+	// simulation and rendering overlap and only meet through scene snapshots
+	bool renderThread = false;
+	// print GPU time per scope every few seconds
+	bool gpuProfile = false;
+	// record CPU and GPU zones and write them there as a Chrome trace at exit
+	std::string tracePath;
+	// also write the trace whenever a frame takes longer than this, 0 disables
+	float hitchMs = 0.0f;
+	// no window, frames are rendered into offscreen images
+	bool headless = false;
+	// stop after this many frames and report the frame rate, 0 runs until the window closes
+	uint32_t frameCount = 0;
+	// headless only, the last frame is written there as a PPM image
+	std::string outputPath;
+	// Sierpinski steps applied to the triangle
+	uint32_t sierpinskiDepth = 0;
+	// generate the mesh with a compute shader straight into its vertex buffer instead of on the CPU
+	bool computeGeometry = false;
+};
+
 class FirstApp{
 public:
 	// app aprameters
 	// size const for now
 	static constexpr int WIDTH = 800;
 	static constexpr int HEIGHT = 600;
+	// simulation rate, independent of how fast frames are rendered
+	static constexpr float FIXED_TIMESTEP = 1.0f / 60.0f;
+	static constexpr float MAX_FRAME_TIME = 0.25f;
 	
-	FirstApp();
+	explicit FirstApp(const FirstAppOptions &options = {});
 	~FirstApp();
 
 	// deleting copy constructors for memory safety
@@ -28,13 +60,28 @@ public:
 	// the application running loop
 	void run();
 private:
-	// our window object created on instance
-	LveWindow lveWindow{WIDTH, HEIGHT, "Hello Vulkan!"};
-	LveDevice lveDevice{lveWindow};
-	LveRenderer lveRenderer{lveWindow, lveDevice};
-	std::vector<LveGameObject> gameObjects;
+	// first, everything below depends on it
+	FirstAppOptions options;
+	// our window object created on instance, nullptr when headless
+	std::unique_ptr<LveWindow> lveWindow;
+	LveDevice lveDevice;
+	// one thread per core, shared by every subsystem
+	LveJobSystem jobSystem{};
+	LveRenderer lveRenderer;
+	LveGameObjectStore gameObjects;
+	// the only object update moves
+	LveGameObject spinningTriangle;
+	LveSceneBuffer sceneBuffer;
+	std::atomic<uint32_t> renderedFrames{0};
+	std::chrono::steady_clock::time_point lastProfilePrint{};
+	std::chrono::steady_clock::time_point lastTraceDump{};
 
 	
 	void loadGameObjects();
+	// game logic, advances the simulation by one fixed step
+	void update(float deltaTime);
+	// renders the latest published snapshot
+	void renderFrame(SimpleRenderSystem &simpleRenderSystem);
+	void printGpuProfile();
 };
 }
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include "lve_allocator.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vulkan/vulkan_core.h>
+
+namespace lve {
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment){
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+// bufferImageGranularity is a "page" that linear and optimal resources can't share (spec 12.7)
+static bool onSamePage(VkDeviceSize aLastByte, VkDeviceSize bFirstByte, VkDeviceSize pageSize){
+	return (aLastByte & ~(pageSize - 1)) == (bFirstByte & ~(pageSize - 1));
+}
+
+LveMemoryBlock::LveMemoryBlock(VkDevice device, uint32_t memoryTypeIndex, VkDeviceSize size, bool hostVisible) :
+	device(device), size(size), memoryTypeIndex(memoryTypeIndex){
+
+	VkMemoryAllocateInfo allocInfo{
+		.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+		.allocationSize = size,
+		.memoryTypeIndex = memoryTypeIndex,
+	};
+
+	if(vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS){
+		throw std::runtime_error("Failed to allocate memory block");
+	}
+
+	// host visible blocks stay mapped for their whole life, a block can only be mapped once anyway
+	if(hostVisible && vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS){
+		vkFreeMemory(device, memory, nullptr);
+		throw std::runtime_error("Failed to map memory block");
+	}
+
+	chunks[0] = {size, true, true};
+	insertFree(0, size);
+}
+
+LveMemoryBlock::~LveMemoryBlock(){
+	if(mapped != nullptr){
+		vkUnmapMemory(device, memory);
+	}
+	vkFreeMemory(device, memory, nullptr);
+}
+
+void LveMemoryBlock::insertFree(VkDeviceSize offset, VkDeviceSize chunkSize){
+	freeChunks.emplace(chunkSize, offset);
+}
+
+void LveMemoryBlock::eraseFree(VkDeviceSize offset, VkDeviceSize chunkSize){
+	auto range = freeChunks.equal_range(chunkSize);
+	for(auto it = range.first; it != range.second; it++){
+		if(it->second == offset){
+			freeChunks.erase(it);
+			return;
+		}
+	}
+	assert(false && "Free chunk missing from the free list");
+}
+
+bool LveMemoryBlock::allocate(VkDeviceSize allocSize, VkDeviceSize alignment, bool linear, VkDeviceSize granularity, LveAllocation &allocation){
+	if(size - usedBytes < allocSize){
+		return false;
+	}
+
+	// smallest free chunk first, bigger ones only if alignment or granularity pushes us out
+	for(auto freeIt = freeChunks.lower_bound(allocSize); freeIt != freeChunks.end(); freeIt++){
+		auto it = chunks.find(freeIt->second);
+		assert(it != chunks.end() && it->second.free);
+
+		const VkDeviceSize chunkStart = it->first;
+		const VkDeviceSize chunkEnd = chunkStart + it->second.size;
+		VkDeviceSize offset = alignUp(chunkStart, alignment);
+
+		// free chunks are always merged, so both neighbours (if any) are in use
+		if(granularity > 1 && it != chunks.begin()){
+			auto prev = std::prev(it);
+			if(prev->second.linear != linear && onSamePage(prev->first + prev->second.size - 1, offset, granularity)){
+				offset = alignUp(offset, granularity);
+			}
+		}
+		if(offset + allocSize > chunkEnd){
+			continue;
+		}
+		auto next = std::next(it);
+		if(granularity > 1 && next != chunks.end()){
+			if(next->second.linear != linear && onSamePage(offset + allocSize - 1, next->first, granularity)){
+				continue;
+			}
+		}
+
+		// split the chunk into [padding][allocation][remainder]
+		freeChunks.erase(freeIt);
+		if(offset > chunkStart){
+			it->second.size = offset - chunkStart;
+			insertFree(chunkStart, it->second.size);
+		}
+		else{
+			chunks.erase(it);
+		}
+		chunks[offset] = {allocSize, false, linear};
+		if(offset + allocSize < chunkEnd){
+			chunks[offset + allocSize] = {chunkEnd - offset - allocSize, true, linear};
+			insertFree(offset + allocSize, chunkEnd - offset - allocSize);
+		}
+		usedBytes += allocSize;
+
+		allocation.memory = memory;
+		allocation.offset = offset;
+		allocation.size = allocSize;
+		allocation.memoryTypeIndex = memoryTypeIndex;
+		allocation.mapped = mapped != nullptr ? static_cast<char*>(mapped) + offset : nullptr;
+		allocation.block = this;
+		return true;
+	}
+
+	return false;
+}
+
+void LveMemoryBlock::free(const LveAllocation &allocation){
+	auto it = chunks.find(allocation.offset);
+	assert(it != chunks.end() && !it->second.free && "Freeing an allocation not owned by this block");
+
+	it->second.free = true;
+	usedBytes -= it->second.size;
+
+	// coalesce with the following chunk
+	auto next = std::next(it);
+	if(next != chunks.end() && next->second.free){
+		eraseFree(next->first, next->second.size);
+		it->second.size += next->second.size;
+		chunks.erase(next);
+	}
+	// and with the preceding one
+	if(it != chunks.begin()){
+		auto prev = std::prev(it);
+		if(prev->second.free){
+			eraseFree(prev->first, prev->second.size);
+			prev->second.size += it->second.size;
+			chunks.erase(it);
+			it = prev;
+		}
+	}
+	insertFree(it->first, it->second.size);
+}
+
+LveAllocator::LveAllocator(VkPhysicalDevice physicalDevice, VkDevice device) : device(device){
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	bufferImageGranularity = properties.limits.bufferImageGranularity;
+
+	// small heaps (like the 256MB BAR window) get proportionally smaller blocks
+	preferredBlockSizes.resize(memProperties.memoryTypeCount);
+	for(uint32_t i = 0; i < memProperties.memoryTypeCount; i++){
+		VkDeviceSize heapSize = memProperties.memoryHeaps[memProperties.memoryTypes[i].heapIndex].size;
+		preferredBlockSizes[i] = std::min(DEFAULT_BLOCK_SIZE, alignUp(heapSize / 8, 256));
+	}
+
+	blocks.resize(memProperties.memoryTypeCount);
+}
+
+LveAllocator::~LveAllocator(){
+	blocks.clear();
+}
+
+LveAllocation LveAllocator::allocate(const VkMemoryRequirements &requirements, uint32_t memoryTypeIndex, bool linear){
+	std::lock_guard<std::mutex> lock(mutex);
+	assert(memoryTypeIndex < memProperties.memoryTypeCount && "Invalid memory type");
+
+	LveAllocation allocation{};
+	auto &typeBlocks = blocks[memoryTypeIndex];
+
+	for(auto &block : typeBlocks){
+		if(block->allocate(requirements.size, requirements.alignment, linear, bufferImageGranularity, allocation)){
+			return allocation;
+		}
+	}
+
+	// resources bigger than half a block get their own block so they don't fragment the others
+	VkDeviceSize blockSize = preferredBlockSizes[memoryTypeIndex];
+	if(requirements.size > blockSize / 2){
+		blockSize = requirements.size;
+	}
+
+	bool hostVisible = memProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+	typeBlocks.push_back(std::make_unique<LveMemoryBlock>(device, memoryTypeIndex, blockSize, hostVisible));
+
+	if(!typeBlocks.back()->allocate(requirements.size, requirements.alignment, linear, bufferImageGranularity, allocation)){
+		throw std::runtime_error("Failed to sub-allocate from a fresh memory block");
+	}
+	return allocation;
+}
+
+void LveAllocator::free(LveAllocation &allocation){
+	if(allocation.block == nullptr){
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto &typeBlocks = blocks[allocation.memoryTypeIndex];
+	allocation.block->free(allocation);
+
+	// give empty blocks back to the driver but keep one around for the next allocation
+	if(allocation.block->isEmpty() &&
+	  (typeBlocks.size() > 1 || allocation.block->getSize() != preferredBlockSizes[allocation.memoryTypeIndex])){
+		typeBlocks.erase(std::find_if(typeBlocks.begin(), typeBlocks.end(),
+			[&](const auto &block){ return block.get() == allocation.block; }));
+	}
+
+	allocation = LveAllocation{};
+}
+
+uint32_t LveAllocator::getBlockCount() const{
+	std::lock_guard<std::mutex> lock(mutex);
+	size_t count = 0;
+	for(const auto &typeBlocks : blocks){
+		count += typeBlocks.size();
+	}
+	return static_cast<uint32_t>(count);
+}
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace lve {
+
+class LveMemoryBlock;
+
+// a sub range of a bigger VkDeviceMemory block
+struct LveAllocation {
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkDeviceSize offset = 0;
+	VkDeviceSize size = 0;
+	uint32_t memoryTypeIndex = 0;
+	void *mapped = nullptr; // already offset, only set for host visible memory
+	LveMemoryBlock *block = nullptr;
+};
+
+// one big vkAllocateMemory chopped into best fit chunks
+class LveMemoryBlock {
+public:
+	LveMemoryBlock(VkDevice device, uint32_t memoryTypeIndex, VkDeviceSize size, bool hostVisible);
+	~LveMemoryBlock();
+
+	LveMemoryBlock(const LveMemoryBlock&) = delete;
+	LveMemoryBlock operator=(const LveMemoryBlock&) = delete;
+
+	// returns false if there is no free chunk big enough
+	bool allocate(VkDeviceSize size, VkDeviceSize alignment, bool linear, VkDeviceSize granularity, LveAllocation &allocation);
+	void free(const LveAllocation &allocation);
+
+	bool isEmpty() const { return usedBytes == 0; }
+	VkDeviceSize getSize() const { return size; }
+
+private:
+	struct Chunk {
+		VkDeviceSize size;
+		bool free;
+		bool linear; // buffers and linear images vs optimal images
+	};
+
+	VkDevice device;
+	VkDeviceMemory memory;
+	VkDeviceSize size;
+	VkDeviceSize usedBytes = 0;
+	uint32_t memoryTypeIndex;
+	void *mapped = nullptr;
+	// keyed by offset so neighbours are always next to each other
+	std::map<VkDeviceSize, Chunk> chunks;
+	// free list, size -> offset, for best fit lookups
+	std::multimap<VkDeviceSize, VkDeviceSize> freeChunks;
+
+	void insertFree(VkDeviceSize offset, VkDeviceSize chunkSize);
+	void eraseFree(VkDeviceSize offset, VkDeviceSize chunkSize);
+};
+
+// hands out offsets into large per memory type blocks instead of one vkAllocateMemory per resource
+class LveAllocator {
+public:
+	static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+
+	LveAllocator(VkPhysicalDevice physicalDevice, VkDevice device);
+	~LveAllocator();
+
+	LveAllocator(const LveAllocator&) = delete;
+	LveAllocator operator=(const LveAllocator&) = delete;
+
+	// linear is true for buffers and linear tiled images, needed to honor bufferImageGranularity
+	LveAllocation allocate(const VkMemoryRequirements &requirements, uint32_t memoryTypeIndex, bool linear);
+	void free(LveAllocation &allocation);
+
+	uint32_t getBlockCount() const;
+
+private:
+	VkDevice device;
+	VkPhysicalDeviceMemoryProperties memProperties;
+	VkDeviceSize bufferImageGranularity;
+	std::vector<VkDeviceSize> preferredBlockSizes;
+	// one list of blocks per memory type
+	std::vector<std::vector<std::unique_ptr<LveMemoryBlock>>> blocks;
+	mutable std::mutex mutex;
+};
+
+}
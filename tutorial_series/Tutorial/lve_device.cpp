@@ -1,8 +1,12 @@
 #include "lve_device.hpp"
+#include "lve_upload_context.hpp"
 
 // std headers
+#include <cstdio>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <limits>
 #include <set>
 #include <unordered_set>
 
@@ -47,24 +51,40 @@ void DestroyDebugUtilsMessengerEXT(
 }
 
 // class member functions
-LveDevice::LveDevice(LveWindow &window) : window{window} {
+LveDevice::LveDevice(LveWindow &window) : window{&window} {
+  deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+  init();
+}
+
+LveDevice::LveDevice() : window{nullptr} { init(); }
+
+void LveDevice::init() {
   createInstance();
   setupDebugMessenger();
   createSurface();
   pickPhysicalDevice();
   createLogicalDevice();
+  createAllocator();
   createCommandPool();
+  createUploadContext();
+  createPipelineCache();
 }
 
 LveDevice::~LveDevice() {
+  savePipelineCache();
+  vkDestroyPipelineCache(device_, pipelineCache_, nullptr);
+  uploadContext_.reset();
   vkDestroyCommandPool(device_, commandPool, nullptr);
+  allocator.reset();
   vkDestroyDevice(device_, nullptr);
 
   if (enableValidationLayers) {
     DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
   }
 
-  vkDestroySurfaceKHR(instance, surface_, nullptr);
+  if (surface_ != VK_NULL_HANDLE) {
+    vkDestroySurfaceKHR(instance, surface_, nullptr);
+  }
   vkDestroyInstance(instance, nullptr);
 }
 
@@ -130,7 +150,37 @@ void LveDevice::pickPhysicalDevice() {
   }
 
   vkGetPhysicalDeviceProperties(physicalDevice, &properties);
-  std::cout << "physical device: " << properties.deviceName << std::endl;
+  std::cout << "physical device: " << properties.deviceName << (isHeadless() ? " (headless)" : "")
+            << std::endl;
+
+  VkPhysicalDeviceFeatures supportedFeatures;
+  vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+  samplerAnisotropy_ = supportedFeatures.samplerAnisotropy;
+
+  hostVisibleDeviceLocalType_ = findHostVisibleDeviceLocalMemoryType();
+  // only worth knowing while debugging upload paths
+  if (enableValidationLayers) {
+    std::cout << "host visible device local memory: " << (hasHostVisibleDeviceLocalMemory() ? "yes" : "no") << std::endl;
+  }
+}
+
+uint32_t LveDevice::findHostVisibleDeviceLocalMemoryType() {
+  // without resizable BAR such types only cover a 256MB window, too small to put meshes in
+  constexpr VkDeviceSize SMALL_BAR_SIZE = 256 * 1024 * 1024;
+  constexpr VkMemoryPropertyFlags flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
+                                          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+  VkPhysicalDeviceMemoryProperties memProperties;
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+  for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+    const VkMemoryType &type = memProperties.memoryTypes[i];
+    if ((type.propertyFlags & flags) == flags &&
+        memProperties.memoryHeaps[type.heapIndex].size > SMALL_BAR_SIZE) {
+      return i;
+    }
+  }
+  return NO_MEMORY_TYPE;
 }
 
 void LveDevice::createLogicalDevice() {
@@ -150,7 +200,7 @@ void LveDevice::createLogicalDevice() {
   }
 
   VkPhysicalDeviceFeatures deviceFeatures = {};
-  deviceFeatures.samplerAnisotropy = VK_TRUE;
+  deviceFeatures.samplerAnisotropy = samplerAnisotropy_ ? VK_TRUE : VK_FALSE;
 
   VkDeviceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -193,24 +243,103 @@ void LveDevice::createCommandPool() {
   }
 }
 
-void LveDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
+void LveDevice::createAllocator() {
+  allocator = std::make_unique<LveAllocator>(physicalDevice, device_);
+}
+
+void LveDevice::createUploadContext() { uploadContext_ = std::make_unique<LveUploadContext>(*this); }
+
+void LveDevice::createPipelineCache() {
+  std::vector<char> cacheData;
+  std::ifstream file{PIPELINE_CACHE_PATH, std::ios::ate | std::ios::binary};
+  if (file.is_open()) {
+    cacheData.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(cacheData.data(), cacheData.size());
+  }
+
+  // a cache from another driver or GPU is useless at best, start from scratch instead
+  if (!cacheData.empty() && !isPipelineCacheCompatible(cacheData)) {
+    std::cout << "pipeline cache: ignoring stale " << PIPELINE_CACHE_PATH << std::endl;
+    cacheData.clear();
+  }
+
+  VkPipelineCacheCreateInfo cacheInfo{};
+  cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  cacheInfo.initialDataSize = cacheData.size();
+  cacheInfo.pInitialData = cacheData.empty() ? nullptr : cacheData.data();
+
+  if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache_) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create pipeline cache!");
+  }
+}
+
+bool LveDevice::isPipelineCacheCompatible(const std::vector<char> &cacheData) {
+  // VkPipelineCacheHeaderVersionOne, read field by field to not depend on struct packing
+  uint32_t headerSize, headerVersion, vendorID, deviceID;
+  uint8_t cacheUUID[VK_UUID_SIZE];
+  if (cacheData.size() < 16 + VK_UUID_SIZE) {
+    return false;
+  }
+  memcpy(&headerSize, cacheData.data(), 4);
+  memcpy(&headerVersion, cacheData.data() + 4, 4);
+  memcpy(&vendorID, cacheData.data() + 8, 4);
+  memcpy(&deviceID, cacheData.data() + 12, 4);
+  memcpy(cacheUUID, cacheData.data() + 16, VK_UUID_SIZE);
+
+  return headerSize >= 16 + VK_UUID_SIZE && headerSize <= cacheData.size() &&
+         headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+         vendorID == properties.vendorID && deviceID == properties.deviceID &&
+         memcmp(cacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+void LveDevice::savePipelineCache() {
+  size_t dataSize = 0;
+  if (vkGetPipelineCacheData(device_, pipelineCache_, &dataSize, nullptr) != VK_SUCCESS ||
+      dataSize == 0) {
+    return;
+  }
+  std::vector<char> cacheData(dataSize);
+  if (vkGetPipelineCacheData(device_, pipelineCache_, &dataSize, cacheData.data()) != VK_SUCCESS) {
+    return;
+  }
+
+  // write next to the real file and swap, so a crash never leaves a half written cache behind
+  std::string tmpPath = std::string(PIPELINE_CACHE_PATH) + ".tmp";
+  std::ofstream file{tmpPath, std::ios::binary | std::ios::trunc};
+  if (!file.is_open()) {
+    std::cerr << "pipeline cache: failed to open " << tmpPath << std::endl;
+    return;
+  }
+  file.write(cacheData.data(), dataSize);
+  file.close();
+  if (!file || std::rename(tmpPath.c_str(), PIPELINE_CACHE_PATH) != 0) {
+    std::cerr << "pipeline cache: failed to save " << PIPELINE_CACHE_PATH << std::endl;
+    std::remove(tmpPath.c_str());
+  }
+}
+
+void LveDevice::createSurface() {
+  if (window != nullptr) {
+    window->createWindowSurface(instance, &surface_);
+  }
+}
 
 bool LveDevice::isDeviceSuitable(VkPhysicalDevice device) {
   QueueFamilyIndices indices = findQueueFamilies(device);
 
   bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-  bool swapChainAdequate = false;
-  if (extensionsSupported) {
+  // nothing to present to without a window
+  bool swapChainAdequate = isHeadless();
+  if (extensionsSupported && !isHeadless()) {
     SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
     swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
   }
 
-  VkPhysicalDeviceFeatures supportedFeatures;
-  vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
-
-  return indices.isComplete() && extensionsSupported && swapChainAdequate &&
-         supportedFeatures.samplerAnisotropy;
+  // anisotropy is enabled when available but not required, software rasterizers may lack it
+  // and nothing samples textures yet
+  return indices.isComplete() && extensionsSupported && swapChainAdequate;
 }
 
 void LveDevice::populateDebugMessengerCreateInfo(
@@ -261,11 +390,14 @@ bool LveDevice::checkValidationLayerSupport() {
 }
 
 std::vector<const char *> LveDevice::getRequiredExtensions() {
-  uint32_t glfwExtensionCount = 0;
-  const char **glfwExtensions;
-  glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-  std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  // glfw is never initialized when headless and has nothing to ask for
+  std::vector<const char *> extensions;
+  if (!isHeadless()) {
+    uint32_t glfwExtensionCount = 0;
+    const char **glfwExtensions;
+    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  }
 
   if (enableValidationLayers) {
     extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -317,6 +449,14 @@ bool LveDevice::checkDeviceExtensionSupport(VkPhysicalDevice device) {
   return requiredExtensions.empty();
 }
 
+uint32_t LveDevice::getGraphicsTimestampValidBits() {
+  uint32_t queueFamilyCount = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+  std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+  return queueFamilies[findPhysicalQueueFamilies().graphicsFamily].timestampValidBits;
+}
+
 QueueFamilyIndices LveDevice::findQueueFamilies(VkPhysicalDevice device) {
   QueueFamilyIndices indices;
 
@@ -333,7 +473,12 @@ QueueFamilyIndices LveDevice::findQueueFamilies(VkPhysicalDevice device) {
       indices.graphicsFamilyHasValue = true;
     }
     VkBool32 presentSupport = false;
-    vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+    if (isHeadless()) {
+      // nothing gets presented, the graphics queue stands in so both indices stay valid
+      presentSupport = queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT;
+    } else {
+      vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+    }
     if (queueFamily.queueCount > 0 && presentSupport) {
       indices.presentFamily = i;
       indices.presentFamilyHasValue = true;
@@ -408,7 +553,8 @@ void LveDevice::createBuffer(
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkBuffer &buffer,
-    VkDeviceMemory &bufferMemory) {
+    LveAllocation &bufferMemory,
+    uint32_t memoryTypeIndex) {
   VkBufferCreateInfo bufferInfo{};
   bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   bufferInfo.size = size;
@@ -422,16 +568,26 @@ void LveDevice::createBuffer(
   VkMemoryRequirements memRequirements;
   vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-  VkMemoryAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-    throw std::runtime_error("failed to allocate vertex buffer memory!");
+  // nothing is handed out when this throws, so undo whatever was created so far
+  try {
+    if (memoryTypeIndex == NO_MEMORY_TYPE) {
+      memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+    } else if ((memRequirements.memoryTypeBits & (1u << memoryTypeIndex)) == 0) {
+      throw std::runtime_error("buffer can't use the requested memory type!");
+    }
+    bufferMemory = allocator->allocate(memRequirements, memoryTypeIndex, true);
+  } catch (...) {
+    vkDestroyBuffer(device_, buffer, nullptr);
+    buffer = VK_NULL_HANDLE;
+    throw;
   }
 
-  vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+  if (vkBindBufferMemory(device_, buffer, bufferMemory.memory, bufferMemory.offset) != VK_SUCCESS) {
+    vkDestroyBuffer(device_, buffer, nullptr);
+    buffer = VK_NULL_HANDLE;
+    allocator->free(bufferMemory);
+    throw std::runtime_error("failed to bind buffer memory!");
+  }
 }
 
 VkCommandBuffer LveDevice::beginSingleTimeCommands() {
@@ -460,56 +616,40 @@ void LveDevice::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
   submitInfo.commandBufferCount = 1;
   submitInfo.pCommandBuffers = &commandBuffer;
 
-  vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-  vkQueueWaitIdle(graphicsQueue_);
+  // wait on this submission only, not on everything else queued on the graphics queue
+  VkFenceCreateInfo fenceInfo{};
+  fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  VkFence fence;
+  if (vkCreateFence(device_, &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create single time command fence!");
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    vkQueueSubmit(graphicsQueue_, 1, &submitInfo, fence);
+  }
+  vkWaitForFences(device_, 1, &fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
 
+  vkDestroyFence(device_, fence, nullptr);
   vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
 }
 
 void LveDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
-  VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-  VkBufferCopy copyRegion{};
-  copyRegion.srcOffset = 0;  // Optional
-  copyRegion.dstOffset = 0;  // Optional
-  copyRegion.size = size;
-  vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-
-  endSingleTimeCommands(commandBuffer);
+  uploadContext_->copyBuffer(srcBuffer, dstBuffer, size);
+  uploadContext_->wait(uploadContext_->submit());
 }
 
 void LveDevice::copyBufferToImage(
     VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount) {
-  VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-  VkBufferImageCopy region{};
-  region.bufferOffset = 0;
-  region.bufferRowLength = 0;
-  region.bufferImageHeight = 0;
-
-  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  region.imageSubresource.mipLevel = 0;
-  region.imageSubresource.baseArrayLayer = 0;
-  region.imageSubresource.layerCount = layerCount;
-
-  region.imageOffset = {0, 0, 0};
-  region.imageExtent = {width, height, 1};
-
-  vkCmdCopyBufferToImage(
-      commandBuffer,
-      buffer,
-      image,
-      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-      1,
-      &region);
-  endSingleTimeCommands(commandBuffer);
+  uploadContext_->copyBufferToImage(buffer, image, width, height, layerCount);
+  uploadContext_->wait(uploadContext_->submit());
 }
 
 void LveDevice::createImageWithInfo(
     const VkImageCreateInfo &imageInfo,
     VkMemoryPropertyFlags properties,
     VkImage &image,
-    VkDeviceMemory &imageMemory) {
+    LveAllocation &imageMemory) {
   if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
     throw std::runtime_error("failed to create image!");
   }
@@ -517,16 +657,22 @@ void LveDevice::createImageWithInfo(
   VkMemoryRequirements memRequirements;
   vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-  VkMemoryAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-    throw std::runtime_error("failed to allocate image memory!");
+  // same cleanup as createBuffer
+  try {
+    imageMemory = allocator->allocate(
+        memRequirements,
+        findMemoryType(memRequirements.memoryTypeBits, properties),
+        imageInfo.tiling == VK_IMAGE_TILING_LINEAR);
+  } catch (...) {
+    vkDestroyImage(device_, image, nullptr);
+    image = VK_NULL_HANDLE;
+    throw;
   }
 
-  if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
+  if (vkBindImageMemory(device_, image, imageMemory.memory, imageMemory.offset) != VK_SUCCESS) {
+    vkDestroyImage(device_, image, nullptr);
+    image = VK_NULL_HANDLE;
+    allocator->free(imageMemory);
     throw std::runtime_error("failed to bind image memory!");
   }
 }
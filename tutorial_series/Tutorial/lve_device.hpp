@@ -1,13 +1,19 @@
 #pragma once
 
+#include "lve_allocator.hpp"
 #include "lve_window.hpp"
 
 // std lib headers
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 namespace lve {
 
+class LveUploadContext;
+
 struct SwapChainSupportDetails {
   VkSurfaceCapabilitiesKHR capabilities;
   std::vector<VkSurfaceFormatKHR> formats;
@@ -30,7 +36,13 @@ class LveDevice {
   const bool enableValidationLayers = true;
 #endif
 
+  // where the pipeline cache is kept between runs
+  static constexpr const char *PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+
   LveDevice(LveWindow &window);
+  // headless, no surface and no swap chain extension so it runs without a display, e.g. on lavapipe.
+  // Render into an LveOffscreenTarget instead of a swap chain.
+  LveDevice();
   ~LveDevice();
 
   // Not copyable or movable
@@ -42,24 +54,40 @@ class LveDevice {
   VkCommandPool getCommandPool() { return commandPool; }
   VkDevice device() { return device_; }
   VkSurfaceKHR surface() { return surface_; }
+  bool isHeadless() { return window == nullptr; }
   VkQueue graphicsQueue() { return graphicsQueue_; }
   VkQueue presentQueue() { return presentQueue_; }
+  // vulkan wants submits, presents and device wide waits externally synchronized,
+  // hold this around them once more than one thread talks to the queues
+  std::mutex &queueMutex() { return queueMutex_; }
+  LveUploadContext &uploadContext() { return *uploadContext_; }
+  VkPipelineCache pipelineCache() { return pipelineCache_; }
+  static constexpr uint32_t NO_MEMORY_TYPE = UINT32_MAX;
+  // resizable BAR or unified memory, device local buffers can be written by the CPU directly
+  bool hasHostVisibleDeviceLocalMemory() { return hostVisibleDeviceLocalType_ != NO_MEMORY_TYPE; }
+  // the memory type that made hasHostVisibleDeviceLocalMemory true, pass it to createBuffer
+  uint32_t getHostVisibleDeviceLocalMemoryType() { return hostVisibleDeviceLocalType_; }
 
   SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
   uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
   QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
+  // 0 if the graphics queue can't write timestamps
+  uint32_t getGraphicsTimestampValidBits();
   VkFormat findSupportedFormat(
       const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
   // Buffer Helper Functions
+  // memoryTypeIndex picks the exact type instead of the first one with `properties`
   void createBuffer(
       VkDeviceSize size,
       VkBufferUsageFlags usage,
       VkMemoryPropertyFlags properties,
       VkBuffer &buffer,
-      VkDeviceMemory &bufferMemory);
+      LveAllocation &bufferMemory,
+      uint32_t memoryTypeIndex = NO_MEMORY_TYPE);
   VkCommandBuffer beginSingleTimeCommands();
   void endSingleTimeCommands(VkCommandBuffer commandBuffer);
+  // blocking copies, use uploadContext() directly to batch many of them into one submit
   void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
   void copyBufferToImage(
       VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
@@ -68,17 +96,25 @@ class LveDevice {
       const VkImageCreateInfo &imageInfo,
       VkMemoryPropertyFlags properties,
       VkImage &image,
-      VkDeviceMemory &imageMemory);
+      LveAllocation &imageMemory);
+
+  // Returns memory from createBuffer / createImageWithInfo to the sub-allocator
+  void freeMemory(LveAllocation &allocation) { allocator->free(allocation); }
 
   VkPhysicalDeviceProperties properties;
 
  private:
+  void init();
   void createInstance();
   void setupDebugMessenger();
   void createSurface();
   void pickPhysicalDevice();
   void createLogicalDevice();
   void createCommandPool();
+  void createAllocator();
+  void createUploadContext();
+  void createPipelineCache();
+  void savePipelineCache();
 
   // helper functions
   bool isDeviceSuitable(VkPhysicalDevice device);
@@ -88,21 +124,29 @@ class LveDevice {
   void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
   void hasGflwRequiredInstanceExtensions();
   bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+  bool isPipelineCacheCompatible(const std::vector<char> &cacheData);
+  uint32_t findHostVisibleDeviceLocalMemoryType();
   SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
   VkInstance instance;
   VkDebugUtilsMessengerEXT debugMessenger;
   VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-  LveWindow &window;
+  LveWindow *window;
   VkCommandPool commandPool;
 
   VkDevice device_;
-  VkSurfaceKHR surface_;
+  VkSurfaceKHR surface_ = VK_NULL_HANDLE;
   VkQueue graphicsQueue_;
   VkQueue presentQueue_;
+  std::mutex queueMutex_;
+  std::unique_ptr<LveAllocator> allocator;
+  std::unique_ptr<LveUploadContext> uploadContext_;
+  VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
+  uint32_t hostVisibleDeviceLocalType_ = NO_MEMORY_TYPE;
+  bool samplerAnisotropy_ = false;
 
   const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
-  const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+  std::vector<const char *> deviceExtensions;
 };
 
 }  // namespace lve
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include "lve_gpu_profiler.hpp"
+#include "lve_parallel_recorder.hpp"
+
+namespace lve {
+
+// everything a render system needs to know about the frame being recorded
+struct FrameInfo {
+	int frameIndex;
+	VkCommandBuffer commandBuffer;
+	// set when the render pass expects secondary command buffers, record through it instead of commandBuffer
+	LveParallelRecorder *parallelRecorder = nullptr;
+	// how far between the last two simulation steps this frame is, render systems blend towards the latest one
+	float interpolation = 1.0f;
+	// open scopes around what a render system records, nullptr when GPU profiling is unavailable
+	LveGpuProfiler *gpuProfiler = nullptr;
+};
+
+}
@@ -0,0 +1,155 @@
+#include "lve_game_object.hpp"
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace lve {
+
+LveGameObject LveGameObjectStore::createGameObject(std::shared_ptr<LveModel> model){
+	uint32_t handle;
+	if(!freeHandles.empty()){
+		handle = freeHandles.back();
+		freeHandles.pop_back();
+	}
+	else{
+		handle = static_cast<uint32_t>(handleSlots.size());
+		handleSlots.push_back(INVALID_SLOT);
+		handleGenerations.push_back(0);
+	}
+
+	uint32_t slot = size();
+	handleSlots[handle] = slot;
+	slotHandles.push_back(handle);
+
+	translationData.push_back(glm::vec2{0.0f});
+	scaleData.push_back(glm::vec2{1.0f});
+	rotationData.push_back(0.0f);
+	colorData.push_back(glm::vec3{1.0f});
+	modelData.push_back(std::move(model));
+	previousTranslationData.push_back(translationData.back());
+	previousScaleData.push_back(scaleData.back());
+	previousRotationData.push_back(rotationData.back());
+	changedFlags.push_back(0);
+	movingIndices.push_back(INVALID_SLOT);
+	changeLayout();
+
+	return LveGameObject(this, handle, handleGenerations[handle]);
+}
+
+void LveGameObjectStore::destroyGameObject(LveGameObject object){
+	uint32_t slot = getSlot(object);
+	uint32_t last = size() - 1;
+	changeLayout();
+	removeMoving(slot);
+
+	// keep the arrays dense by moving the last object into the hole
+	if(slot != last){
+		translationData[slot] = translationData[last];
+		scaleData[slot] = scaleData[last];
+		rotationData[slot] = rotationData[last];
+		colorData[slot] = colorData[last];
+		modelData[slot] = std::move(modelData[last]);
+		previousTranslationData[slot] = previousTranslationData[last];
+		previousScaleData[slot] = previousScaleData[last];
+		previousRotationData[slot] = previousRotationData[last];
+		slotHandles[slot] = slotHandles[last];
+		handleSlots[slotHandles[slot]] = slot;
+
+		uint32_t movingIndex = movingIndices[last];
+		if(movingIndex != INVALID_SLOT){
+			movingSlots[movingIndex] = slot;
+			movingIndices[slot] = movingIndex;
+			movingIndices[last] = INVALID_SLOT;
+		}
+	}
+	translationData.pop_back();
+	scaleData.pop_back();
+	rotationData.pop_back();
+	colorData.pop_back();
+	modelData.pop_back();
+	previousTranslationData.pop_back();
+	previousScaleData.pop_back();
+	previousRotationData.pop_back();
+	slotHandles.pop_back();
+	changedFlags.pop_back();
+	movingIndices.pop_back();
+
+	handleSlots[object.handle] = INVALID_SLOT;
+	handleGenerations[object.handle]++;
+	freeHandles.push_back(object.handle);
+}
+
+bool LveGameObjectStore::isAlive(LveGameObject object) const {
+	return object.store == this &&
+		object.handle < handleSlots.size() &&
+		handleGenerations[object.handle] == object.generation &&
+		handleSlots[object.handle] != INVALID_SLOT;
+}
+
+void LveGameObjectStore::reserve(uint32_t count){
+	translationData.reserve(count);
+	scaleData.reserve(count);
+	rotationData.reserve(count);
+	colorData.reserve(count);
+	modelData.reserve(count);
+	slotHandles.reserve(count);
+	previousTranslationData.reserve(count);
+	previousScaleData.reserve(count);
+	previousRotationData.reserve(count);
+	changedFlags.reserve(count);
+	movingIndices.reserve(count);
+	handleSlots.reserve(count);
+	handleGenerations.reserve(count);
+}
+
+void LveGameObjectStore::clearChanges(){
+	for(uint32_t slot : changedSlots){
+		changedFlags[slot] = 0;
+	}
+	changedSlots.clear();
+}
+
+void LveGameObjectStore::savePreviousState(){
+	for(uint32_t slot : movingSlots){
+		previousTranslationData[slot] = translationData[slot];
+		previousScaleData[slot] = scaleData[slot];
+		previousRotationData[slot] = rotationData[slot];
+		movingIndices[slot] = INVALID_SLOT;
+		// settles on the current transform, consumers still have to see that once
+		addChanged(slot);
+	}
+	movingSlots.clear();
+}
+
+void LveGameObjectStore::removeMoving(uint32_t slot){
+	uint32_t movingIndex = movingIndices[slot];
+	if(movingIndex == INVALID_SLOT){
+		return;
+	}
+	uint32_t back = movingSlots.back();
+	movingSlots[movingIndex] = back;
+	movingIndices[back] = movingIndex;
+	movingSlots.pop_back();
+	movingIndices[slot] = INVALID_SLOT;
+}
+
+void LveGameObjectStore::changeLayout(){
+	// consumers rebuild everything after a layout change, the old change list is meaningless
+	clearChanges();
+	layoutVersion++;
+}
+
+uint32_t LveGameObjectStore::getSlot(LveGameObject object) const {
+	assert(isAlive(object) && "Game object was destroyed or belongs to another store");
+	return handleSlots[object.handle];
+}
+
+LveGameObject LveGameObjectStore::getGameObject(uint32_t slot){
+	assert(slot < size() && "Slot out of range");
+	uint32_t handle = slotHandles[slot];
+	return LveGameObject(this, handle, handleGenerations[handle]);
+}
+
+}
@@ -1,59 +1,197 @@
 #pragma once
 
+#include <cstdint>
 #include <glm/fwd.hpp>
 #include <glm/trigonometric.hpp>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "lve_model.hpp"
 
 namespace lve {
 
-struct Transform2dComponent{
-	glm::vec2 translation{};
-	glm::vec2 scale{1.0f, 1.0f};
-	float rotation = 0.0f;
-
-	glm::mat2 mat2() {
-		glm::mat2 scaleMat{
-			{scale.x, 0.0f},
-			{0.0f, scale.y}
-		};
-
-		const float s = glm::sin(rotation);
-		const float c = glm::cos(rotation);
-		glm::mat2 rotationMat{
-			{c, s},
-			{-s, c}
-		};
-		return rotationMat * scaleMat; 
-	}
-};
+// rotation * scale, the 2d part of an object's transform
+inline glm::mat2 transform2dMatrix(glm::vec2 scale, float rotation){
+	const float s = glm::sin(rotation);
+	const float c = glm::cos(rotation);
+	return glm::mat2{
+		{c * scale.x, s * scale.x},
+		{-s * scale.y, c * scale.y}
+	};
+}
+
+class LveGameObjectStore;
 
+// lightweight handle into a LveGameObjectStore, copies refer to the same object
 class LveGameObject{
 public:
 	using id_t = unsigned int;
 
-	std::shared_ptr<LveModel> model;
-	glm::vec3 color;
-	Transform2dComponent transform2d;
+	LveGameObject() = default;
 
-	static LveGameObject createGameObject(){
-		static id_t currentId = 0;
-		return LveGameObject(currentId++);
-	}
+	// stable for the lifetime of the object, reused after it is destroyed
+	id_t getId() const {return handle;}
+
+	// component access, only valid while the object is alive, go through the store's arrays for bulk passes.
+	// Reads don't touch change tracking.
+	glm::vec2 getTranslation() const;
+	glm::vec2 getScale() const;
+	float getRotation() const;
+	glm::vec3 getColor() const;
+	const std::shared_ptr<LveModel> &getModel() const;
+
+	// write access, every call marks the object changed, so don't hold on to the reference past the current frame
+	glm::vec2 &translation();
+	glm::vec2 &scale();
+	float &rotation();
+	glm::vec3 &color();
+	// a new model can change the draw grouping, which is a layout change
+	void setModel(std::shared_ptr<LveModel> model);
+
+private:
+	friend class LveGameObjectStore;
+
+	LveGameObjectStore *store = nullptr;
+	uint32_t handle = 0;
+	uint32_t generation = 0;
+
+	LveGameObject(LveGameObjectStore *store, uint32_t handle, uint32_t generation) : store{store}, handle{handle}, generation{generation} {};
+	uint32_t slot() const;
+};
+
+// struct of arrays component storage, slot i of every array belongs to the same object.
+// Slots are kept dense, destroying an object moves the last one into its slot, so keep handles
+// around instead of slots.
+//
+// Edits are tracked so consumers only redo work for objects that changed: in place edits land
+// in a change list, anything moving slots around or swapping models bumps the layout version,
+// after which consumers are expected to rebuild everything and the change list starts over.
+//
+// The transform of the previous simulation step is kept as well so rendering can interpolate
+// between fixed updates, see savePreviousState.
+class LveGameObjectStore{
+public:
+	LveGameObjectStore() = default;
+
+	// handles point back at the store
+	LveGameObjectStore(const LveGameObjectStore&) = delete;
+	LveGameObjectStore &operator=(const LveGameObjectStore&) = delete;
+
+	LveGameObject createGameObject(std::shared_ptr<LveModel> model = nullptr);
+	void destroyGameObject(LveGameObject object);
+	bool isAlive(LveGameObject object) const;
+	void reserve(uint32_t count);
 
-	LveGameObject(const LveGameObject&) = delete;
-	LveGameObject &operator=(const LveGameObject&) = delete;
-	LveGameObject(LveGameObject &&) = default;
-	LveGameObject &operator=(LveGameObject &&) = default;
+	uint32_t size() const {return static_cast<uint32_t>(slotHandles.size());}
+	bool empty() const {return slotHandles.empty();}
+	uint32_t getSlot(LveGameObject object) const;
+	LveGameObject getGameObject(uint32_t slot);
 
-	id_t getId() const {return id;} 
+	// contiguous component arrays, size() entries each. Writes through them aren't tracked,
+	// call markChanged for every slot written. Models only change through handles.
+	glm::vec2 *translations() {return translationData.data();}
+	glm::vec2 *scales() {return scaleData.data();}
+	float *rotations() {return rotationData.data();}
+	glm::vec3 *colors() {return colorData.data();}
+	const glm::vec2 *translations() const {return translationData.data();}
+	const glm::vec2 *scales() const {return scaleData.data();}
+	const float *rotations() const {return rotationData.data();}
+	const glm::vec3 *colors() const {return colorData.data();}
+	const std::shared_ptr<LveModel> *models() const {return modelData.data();}
+	// state as of the last savePreviousState, only differs from the current one for moving slots
+	const glm::vec2 *previousTranslations() const {return previousTranslationData.data();}
+	const glm::vec2 *previousScales() const {return previousScaleData.data();}
+	const float *previousRotations() const {return previousRotationData.data();}
 
+	// change tracking
+	void markChanged(uint32_t slot){
+		addChanged(slot);
+		if(movingIndices[slot] == INVALID_SLOT){
+			movingIndices[slot] = static_cast<uint32_t>(movingSlots.size());
+			movingSlots.push_back(slot);
+		}
+	}
+	// slots edited in place since the last clearChanges, each listed once
+	const std::vector<uint32_t> &getChangedSlots() const {return changedSlots;}
+	void clearChanges();
+	uint32_t getLayoutVersion() const {return layoutVersion;}
+
+	// call before every fixed update, the current transforms become the ones interpolated from.
+	// Also call once after setting up objects outside of an update so they don't blend in from the defaults.
+	void savePreviousState();
+	// slots changed since the last savePreviousState, their interpolated transform depends on the blend factor
+	const std::vector<uint32_t> &getMovingSlots() const {return movingSlots;}
 
 private:
-	id_t id;
+	friend class LveGameObject;
+	static constexpr uint32_t INVALID_SLOT = UINT32_MAX;
+
+	std::vector<glm::vec2> translationData;
+	std::vector<glm::vec2> scaleData;
+	std::vector<float> rotationData;
+	std::vector<glm::vec3> colorData;
+	std::vector<std::shared_ptr<LveModel>> modelData;
 
-	LveGameObject(id_t objId) : id{objId} {};
+	// handle <-> slot indirection, generations catch handles to destroyed objects
+	std::vector<uint32_t> slotHandles;		// per slot
+	std::vector<uint32_t> handleSlots;		// per handle
+	std::vector<uint32_t> handleGenerations;	// per handle
+	std::vector<uint32_t> freeHandles;
+
+	std::vector<glm::vec2> previousTranslationData;
+	std::vector<glm::vec2> previousScaleData;
+	std::vector<float> previousRotationData;
+
+	std::vector<uint8_t> changedFlags;	// per slot
+	std::vector<uint32_t> changedSlots;
+	std::vector<uint32_t> movingIndices;	// per slot, position in movingSlots
+	std::vector<uint32_t> movingSlots;
+	uint32_t layoutVersion = 0;
+
+	void addChanged(uint32_t slot){
+		if(!changedFlags[slot]){
+			changedFlags[slot] = 1;
+			changedSlots.push_back(slot);
+		}
+	}
+	void removeMoving(uint32_t slot);
+	void changeLayout();
 };
 
-}
\ No newline at end of file
+inline glm::vec2 &LveGameObject::translation(){
+	uint32_t index = slot();
+	store->markChanged(index);
+	return store->translationData[index];
+}
+inline glm::vec2 &LveGameObject::scale(){
+	uint32_t index = slot();
+	store->markChanged(index);
+	return store->scaleData[index];
+}
+inline float &LveGameObject::rotation(){
+	uint32_t index = slot();
+	store->markChanged(index);
+	return store->rotationData[index];
+}
+inline glm::vec3 &LveGameObject::color(){
+	uint32_t index = slot();
+	store->markChanged(index);
+	return store->colorData[index];
+}
+inline void LveGameObject::setModel(std::shared_ptr<LveModel> model){
+	uint32_t index = slot();
+	if(store->modelData[index] == model){
+		return;
+	}
+	store->modelData[index] = std::move(model);
+	store->changeLayout();
+}
+inline glm::vec2 LveGameObject::getTranslation() const {return store->translationData[slot()];}
+inline glm::vec2 LveGameObject::getScale() const {return store->scaleData[slot()];}
+inline float LveGameObject::getRotation() const {return store->rotationData[slot()];}
+inline glm::vec3 LveGameObject::getColor() const {return store->colorData[slot()];}
+inline const std::shared_ptr<LveModel> &LveGameObject::getModel() const {return store->modelData[slot()];}
+inline uint32_t LveGameObject::slot() const {return store->getSlot(*this);}
+
+}
@@ -0,0 +1,206 @@
+#include "lve_gpu_profiler.hpp"
+#include "lve_device.hpp"
+#include "lve_profiler.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace lve {
+
+LveGpuProfiler::Scope::Scope(LveGpuProfiler *profiler, VkCommandBuffer commandBuffer, const char *name) : profiler{profiler}, commandBuffer{commandBuffer}, scope{INVALID_SCOPE}{
+	if(profiler != nullptr){
+		scope = profiler->beginScope(name);
+		profiler->writeBeginTimestamp(commandBuffer, scope);
+	}
+}
+
+LveGpuProfiler::Scope::~Scope(){
+	if(profiler != nullptr){
+		profiler->writeEndTimestamp(commandBuffer, scope);
+		profiler->endScope();
+	}
+}
+
+LveGpuProfiler::LveGpuProfiler(LveDevice &device, uint32_t frameCount, uint32_t maxScopes) : lveDevice{device}, maxScopes{maxScopes}, traceTrack{LveProfiler::getTrack("gpu")}{
+	uint32_t validBits = device.getGraphicsTimestampValidBits();
+	timestampMask = validBits >= 64 ? UINT64_MAX : (uint64_t(1) << validBits) - 1;
+	nanosecondsPerTick = device.properties.limits.timestampPeriod;
+
+	frames.resize(frameCount);
+	for(auto &frame : frames){
+		VkQueryPoolCreateInfo poolInfo{
+			.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+			.queryType = VK_QUERY_TYPE_TIMESTAMP,
+			.queryCount = 2 * maxScopes,
+		};
+		if(vkCreateQueryPool(lveDevice.device(), &poolInfo, nullptr, &frame.queryPool) != VK_SUCCESS){
+			throw std::runtime_error("Failed to create timestamp query pool");
+		}
+		frame.scopes.reserve(maxScopes);
+	}
+	results.resize(4 * maxScopes);
+}
+
+LveGpuProfiler::~LveGpuProfiler(){
+	for(auto &frame : frames){
+		vkDestroyQueryPool(lveDevice.device(), frame.queryPool, nullptr);
+	}
+}
+
+bool LveGpuProfiler::isSupported(LveDevice &device){
+	return device.getGraphicsTimestampValidBits() > 0 && device.properties.limits.timestampPeriod > 0.0f;
+}
+
+void LveGpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex){
+	assert(frameIndex < frames.size() && "Frame index out of range");
+	assert(openScopes.empty() && "Scopes left open in the previous frame");
+
+	currentFrame = &frames[frameIndex];
+	collectResults(*currentFrame);
+	currentFrame->scopes.clear();
+	vkCmdResetQueryPool(commandBuffer, currentFrame->queryPool, 0, 2 * maxScopes);
+
+	frameScope = beginScope("frame");
+	writeBeginTimestamp(commandBuffer, frameScope);
+}
+
+void LveGpuProfiler::endFrame(VkCommandBuffer commandBuffer){
+	writeEndTimestamp(commandBuffer, frameScope);
+	endScope();
+	assert(openScopes.empty() && "Scopes left open at the end of the frame");
+	currentFrame->submitTime = LveProfiler::now();
+	currentFrame = nullptr;
+}
+
+uint32_t LveGpuProfiler::beginScope(const char *name){
+	assert(currentFrame != nullptr && "Scopes can only be opened between beginFrame and endFrame");
+
+	uint32_t parent = openScopes.empty() ? INVALID_SCOPE : openScopes.back();
+	uint32_t historyIndex = getHistoryIndex(parent, name);
+	openScopes.push_back(historyIndex);
+
+	if(currentFrame->scopes.size() >= maxScopes){
+		return INVALID_SCOPE;
+	}
+	currentFrame->scopes.push_back({historyIndex});
+	return static_cast<uint32_t>(currentFrame->scopes.size() - 1);
+}
+
+void LveGpuProfiler::endScope(){
+	assert(!openScopes.empty() && "No scope to end");
+	openScopes.pop_back();
+}
+
+void LveGpuProfiler::writeBeginTimestamp(VkCommandBuffer commandBuffer, uint32_t scope){
+	if(scope != INVALID_SCOPE){
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, currentFrame->queryPool, 2 * scope);
+	}
+}
+
+void LveGpuProfiler::writeEndTimestamp(VkCommandBuffer commandBuffer, uint32_t scope){
+	if(scope != INVALID_SCOPE){
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, currentFrame->queryPool, 2 * scope + 1);
+	}
+}
+
+void LveGpuProfiler::collectResults(FrameQueries &frame){
+	uint32_t queryCount = static_cast<uint32_t>(2 * frame.scopes.size());
+	if(queryCount == 0){
+		return;
+	}
+
+	// no wait flag, the fence already signaled, availability catches scopes that never got their timestamps
+	VkResult result = vkGetQueryPoolResults(
+		lveDevice.device(), frame.queryPool, 0, queryCount,
+		queryCount * 2 * sizeof(uint64_t), results.data(), 2 * sizeof(uint64_t),
+		VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+	if(result != VK_SUCCESS && result != VK_NOT_READY){
+		throw std::runtime_error("Failed to read timestamp queries");
+	}
+
+	// the frame scope comes first and can't have started before the frame was submitted
+	if(results[1] != 0){
+		double offset = static_cast<double>(frame.submitTime) - results[0] * nanosecondsPerTick;
+		clockOffset = hasClockOffset ? std::max(clockOffset, offset) : offset;
+		hasClockOffset = true;
+	}
+	bool capturing = LveProfiler::isCapturing() && hasClockOffset;
+
+	for(uint32_t i = 0; i < frame.scopes.size(); i++){
+		const uint64_t *begin = &results[4 * i];
+		const uint64_t *end = &results[4 * i + 2];
+		if(begin[1] == 0 || end[1] == 0){
+			continue;
+		}
+		// masking handles counters that wrapped around inside the scope
+		uint64_t ticks = (end[0] - begin[0]) & timestampMask;
+		auto &history = histories[frame.scopes[i].historyIndex];
+		history.samples[history.nextSample] = static_cast<float>(ticks * nanosecondsPerTick * 1e-6);
+		history.nextSample = (history.nextSample + 1) % HISTORY_LENGTH;
+		history.sampleCount = std::min(history.sampleCount + 1, HISTORY_LENGTH);
+
+		if(capturing){
+			auto start = static_cast<uint64_t>(begin[0] * nanosecondsPerTick + clockOffset);
+			LveProfiler::recordOnTrack(traceTrack, history.traceName, start, start + static_cast<uint64_t>(ticks * nanosecondsPerTick));
+		}
+	}
+}
+
+uint32_t LveGpuProfiler::getHistoryIndex(uint32_t parent, const char *name){
+	for(uint32_t i = 0; i < histories.size(); i++){
+		if(histories[i].parent == parent && histories[i].name == name){
+			return i;
+		}
+	}
+	ScopeHistory history{};
+	history.name = name;
+	history.traceName = LveProfiler::internName(history.name);
+	history.parent = parent;
+	history.depth = parent == INVALID_SCOPE ? 0 : histories[parent].depth + 1;
+	histories.push_back(history);
+	return static_cast<uint32_t>(histories.size() - 1);
+}
+
+std::vector<LveGpuProfiler::ScopeStats> LveGpuProfiler::getStats() const {
+	// depth first so children follow their parent, histories are created parent first
+	std::vector<ScopeStats> stats;
+	std::vector<uint32_t> stack;
+	for(uint32_t i = static_cast<uint32_t>(histories.size()); i-- > 0;){
+		if(histories[i].parent == INVALID_SCOPE){
+			stack.push_back(i);
+		}
+	}
+	while(!stack.empty()){
+		uint32_t index = stack.back();
+		stack.pop_back();
+		auto &history = histories[index];
+
+		ScopeStats scopeStats{history.name, history.depth, history.sampleCount, 0.0f, 0.0f, 0.0f, 0.0f};
+		if(history.sampleCount > 0){
+			scopeStats.lastMs = history.samples[(history.nextSample + HISTORY_LENGTH - 1) % HISTORY_LENGTH];
+			scopeStats.minMs = history.samples[0];
+			scopeStats.maxMs = history.samples[0];
+			float sum = 0.0f;
+			for(uint32_t sample = 0; sample < history.sampleCount; sample++){
+				scopeStats.minMs = std::min(scopeStats.minMs, history.samples[sample]);
+				scopeStats.maxMs = std::max(scopeStats.maxMs, history.samples[sample]);
+				sum += history.samples[sample];
+			}
+			scopeStats.avgMs = sum / history.sampleCount;
+		}
+		stats.push_back(scopeStats);
+
+		for(uint32_t child = static_cast<uint32_t>(histories.size()); child-- > index + 1;){
+			if(histories[child].parent == index){
+				stack.push_back(child);
+			}
+		}
+	}
+	return stats;
+}
+
+}
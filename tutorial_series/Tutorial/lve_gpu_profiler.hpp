@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "lve_device.hpp"
+#include "lve_profiler.hpp"
+
+namespace lve {
+
+// GPU time per frame and per named scope from timestamp queries. Every frame in flight owns a
+// query pool, its results are read back when the frame index comes around again, by which time
+// the frame's fence has signaled, so reading never stalls. Results show up one frame cycle late.
+//
+// Scopes nest. Opening and closing them is single threaded, but the timestamps themselves can be
+// written into any command buffer of the frame, e.g. the first and last secondary of a parallel recording.
+//
+// While a LveProfiler capture runs, results are also recorded as zones on a "gpu" track. GPU ticks are
+// mapped to the CPU clock with the tightest offset that keeps every frame starting after its submit,
+// which is exact for frames that started right away and drifts by at most the queueing delay otherwise.
+class LveGpuProfiler {
+public:
+	static constexpr uint32_t INVALID_SCOPE = UINT32_MAX;
+	// frames the rolling statistics cover
+	static constexpr uint32_t HISTORY_LENGTH = 120;
+
+	struct ScopeStats {
+		std::string name;
+		uint32_t depth;			// 0 for the whole frame
+		uint32_t sampleCount;
+		float lastMs;
+		float minMs;
+		float avgMs;
+		float maxMs;
+	};
+
+	// opens a scope on construction and closes it on destruction, timestamps go into one command buffer
+	class Scope {
+	public:
+		Scope(LveGpuProfiler *profiler, VkCommandBuffer commandBuffer, const char *name);
+		~Scope();
+
+		Scope(const Scope&) = delete;
+		Scope operator=(const Scope&) = delete;
+
+	private:
+		LveGpuProfiler *profiler;
+		VkCommandBuffer commandBuffer;
+		uint32_t scope;
+	};
+
+	LveGpuProfiler(LveDevice &device, uint32_t frameCount, uint32_t maxScopes = 64);
+	~LveGpuProfiler();
+
+	// deleting copy constructors to prevent vulkan object cloning
+	LveGpuProfiler(const LveGpuProfiler&) = delete;
+	LveGpuProfiler operator=(const LveGpuProfiler&) = delete;
+
+	// whether the graphics queue can write timestamps at all, without it every call is a no-op
+	static bool isSupported(LveDevice &device);
+
+	// collects the frame index's previous results, resets its pool and opens the frame scope.
+	// Call right after beginning the command buffer, outside any render pass, once the fence signaled.
+	void beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+	// closes the frame scope, call before ending the command buffer
+	void endFrame(VkCommandBuffer commandBuffer);
+
+	// reserves a scope nested in the innermost open one, INVALID_SCOPE once the pool is full.
+	// `name` only has to live until the call returns.
+	uint32_t beginScope(const char *name);
+	void endScope();
+	void writeBeginTimestamp(VkCommandBuffer commandBuffer, uint32_t scope);
+	void writeEndTimestamp(VkCommandBuffer commandBuffer, uint32_t scope);
+
+	// rolling min/avg/max of every scope seen, parents before their children
+	std::vector<ScopeStats> getStats() const;
+
+private:
+	// one scope opened during a frame
+	struct ScopeRecord {
+		uint32_t historyIndex;
+	};
+
+	struct FrameQueries {
+		VkQueryPool queryPool = VK_NULL_HANDLE;
+		std::vector<ScopeRecord> scopes;	// scope i owns queries 2i and 2i + 1
+		uint64_t submitTime = 0;			// LveProfiler::now() when the frame was closed
+	};
+
+	struct ScopeHistory {
+		std::string name;
+		const char *traceName;
+		uint32_t parent;
+		uint32_t depth;
+		std::array<float, HISTORY_LENGTH> samples{};
+		uint32_t sampleCount = 0;
+		uint32_t nextSample = 0;
+	};
+
+	LveDevice &lveDevice;
+	uint32_t maxScopes;
+	uint64_t timestampMask;
+	double nanosecondsPerTick;
+	std::vector<FrameQueries> frames;
+	FrameQueries *currentFrame = nullptr;
+	uint32_t frameScope = INVALID_SCOPE;
+	std::vector<uint32_t> openScopes;	// history indices of the open scopes, innermost last
+
+	std::vector<ScopeHistory> histories;	// scopes are few, found by a linear search
+	std::vector<uint64_t> results;	// (timestamp, availability) pairs, kept to avoid per frame allocations
+
+	LveProfiler::Track *traceTrack;
+	bool hasClockOffset = false;
+	double clockOffset = 0.0;	// CPU nanoseconds minus GPU nanoseconds
+
+	void collectResults(FrameQueries &frame);
+	uint32_t getHistoryIndex(uint32_t parent, const char *name);
+};
+
+}
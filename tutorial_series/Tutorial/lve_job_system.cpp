@@ -0,0 +1,147 @@
+#include "lve_job_system.hpp"
+#include "lve_profiler.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace lve {
+
+namespace {
+	// which system and worker the current thread belongs to, foreign threads submit to worker 0
+	thread_local const LveJobSystem *currentSystem = nullptr;
+	thread_local uint32_t currentWorker = 0;
+}
+
+LveJobSystem::LveJobSystem(uint32_t threadCount){
+	if(threadCount == 0){
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	for(uint32_t worker = 0; worker < threadCount; worker++){
+		queues.push_back(std::make_unique<WorkerQueue>());
+	}
+	currentSystem = this;
+	currentWorker = 0;
+	for(uint32_t worker = 1; worker < threadCount; worker++){
+		threads.emplace_back(&LveJobSystem::workerLoop, this, worker);
+	}
+}
+
+LveJobSystem::~LveJobSystem(){
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	wakeCondition.notify_all();
+	for(auto &thread : threads){
+		thread.join();
+	}
+	if(currentSystem == this){
+		currentSystem = nullptr;
+	}
+}
+
+uint32_t LveJobSystem::getCurrentWorker() const {
+	return currentSystem == this ? currentWorker : 0;
+}
+
+void LveJobSystem::submit(Counter &counter, JobFunction function, void *data, uint32_t index){
+	counter.pending.fetch_add(1, std::memory_order_relaxed);
+	// counted before it is visible, so popping it can never take the count below zero
+	queuedJobs.fetch_add(1);
+	{
+		auto &queue = *queues[getCurrentWorker()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back({function, data, index, &counter});
+	}
+
+	// a sleeper either sees the new job before it waits or is woken here, see workerLoop
+	if(sleepingWorkers.load() > 0){
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+		}
+		wakeCondition.notify_one();
+	}
+}
+
+bool LveJobSystem::popJob(uint32_t worker, Job &job){
+	auto &queue = *queues[worker];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if(queue.jobs.empty()){
+		return false;
+	}
+	// newest first, its data is most likely still in cache
+	job = queue.jobs.back();
+	queue.jobs.pop_back();
+	return true;
+}
+
+bool LveJobSystem::stealJob(uint32_t worker, Job &job){
+	uint32_t count = getThreadCount();
+	for(uint32_t i = 1; i < count; i++){
+		auto &queue = *queues[(worker + i) % count];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if(!queue.jobs.empty()){
+			// oldest first, usually the biggest piece of work left
+			job = queue.jobs.front();
+			queue.jobs.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+bool LveJobSystem::runOneJob(uint32_t worker){
+	if(queuedJobs.load(std::memory_order_relaxed) == 0){
+		return false;
+	}
+
+	Job job;
+	if(!popJob(worker, job) && !stealJob(worker, job)){
+		return false;
+	}
+	queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+
+	job.function(job.data, job.index);
+	job.counter->pending.fetch_sub(1, std::memory_order_release);
+	return true;
+}
+
+void LveJobSystem::wait(Counter &counter){
+	uint32_t worker = getCurrentWorker();
+	while(!counter.isDone()){
+		if(!runOneJob(worker)){
+			// the remaining jobs are running elsewhere
+			std::this_thread::yield();
+		}
+	}
+}
+
+void LveJobSystem::workerLoop(uint32_t worker){
+	currentSystem = this;
+	currentWorker = worker;
+	LVE_PROFILE_THREAD("job worker");
+
+	constexpr int SPIN_TRIES = 64;
+	int idleTries = 0;
+	while(!stopping.load(std::memory_order_relaxed)){
+		if(runOneJob(worker)){
+			idleTries = 0;
+			continue;
+		}
+		if(++idleTries < SPIN_TRIES){
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepingWorkers.fetch_add(1);
+		wakeCondition.wait(lock, [&]{ return stopping.load() || queuedJobs.load() > 0; });
+		sleepingWorkers.fetch_sub(1);
+		idleTries = 0;
+	}
+}
+
+}
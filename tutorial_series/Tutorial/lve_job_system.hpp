@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lve {
+
+// work stealing scheduler, every worker owns a deque it pushes to and pops from the back of,
+// idle workers steal from the front of the others. The thread constructing it is worker 0 and
+// only runs jobs while it waits on a counter.
+class LveJobSystem {
+public:
+	// jobs are plain function pointers so submitting never allocates a closure
+	using JobFunction = void (*)(void *data, uint32_t index);
+
+	// number of submitted jobs not finished yet, wait on it to join them
+	struct Counter {
+		std::atomic<uint32_t> pending{0};
+		bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+	};
+
+	// threadCount includes the calling thread, 0 picks std::thread::hardware_concurrency()
+	explicit LveJobSystem(uint32_t threadCount = 0);
+	~LveJobSystem();
+
+	// deleting copy constructors, threads can't be cloned
+	LveJobSystem(const LveJobSystem&) = delete;
+	LveJobSystem operator=(const LveJobSystem&) = delete;
+
+	uint32_t getThreadCount() const { return static_cast<uint32_t>(queues.size()); }
+
+	// jobs must not throw, `data` has to stay alive until the counter is done
+	void submit(Counter &counter, JobFunction function, void *data, uint32_t index = 0);
+	// runs other jobs until the counter reaches zero, so waiting from inside a job can't deadlock
+	void wait(Counter &counter);
+
+	// calls fn(begin, end) over [0, count) in chunks of grainSize and returns when all finished,
+	// the first exception thrown by fn is rethrown here once every chunk is done
+	template<typename Fn>
+	void parallelFor(uint32_t count, uint32_t grainSize, const Fn &fn){
+		if(count == 0){
+			return;
+		}
+		grainSize = std::max(grainSize, 1u);
+		uint32_t chunkCount = (count + grainSize - 1) / grainSize;
+		if(chunkCount == 1){
+			fn(0u, count);
+			return;
+		}
+
+		struct Range {
+			const Fn *fn;
+			uint32_t count;
+			uint32_t grainSize;
+			std::atomic<bool> failed{false};
+			std::exception_ptr error;
+		} range{&fn, count, grainSize, {false}, nullptr};
+
+		Counter counter;
+		for(uint32_t chunk = 0; chunk < chunkCount; chunk++){
+			submit(counter, [](void *data, uint32_t chunk){
+				auto range = static_cast<Range*>(data);
+				uint32_t begin = chunk * range->grainSize;
+				try{
+					(*range->fn)(begin, std::min(begin + range->grainSize, range->count));
+				}
+				catch(...){
+					if(!range->failed.exchange(true)){
+						range->error = std::current_exception();
+					}
+				}
+			}, &range, chunk);
+		}
+		wait(counter);
+		if(range.error){
+			std::rethrow_exception(range.error);
+		}
+	}
+
+	// splits [0, count) into about `tasksPerThread` chunks per thread, no smaller than minGrainSize
+	template<typename Fn>
+	void parallelFor(uint32_t count, const Fn &fn, uint32_t minGrainSize = 256, uint32_t tasksPerThread = 4){
+		uint32_t chunks = getThreadCount() * tasksPerThread;
+		parallelFor(count, std::max(minGrainSize, (count + chunks - 1) / chunks), fn);
+	}
+
+private:
+	struct Job {
+		JobFunction function;
+		void *data;
+		uint32_t index;
+		Counter *counter;
+	};
+
+	// padded so neighbouring queues don't share a cache line
+	struct alignas(64) WorkerQueue {
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	std::vector<std::unique_ptr<WorkerQueue>> queues;
+	std::vector<std::thread> threads;
+	std::atomic<uint32_t> queuedJobs{0};
+	std::atomic<uint32_t> sleepingWorkers{0};
+	std::atomic<bool> stopping{false};
+	std::mutex sleepMutex;
+	std::condition_variable wakeCondition;
+
+	uint32_t getCurrentWorker() const;
+	bool popJob(uint32_t worker, Job &job);
+	bool stealJob(uint32_t worker, Job &job);
+	bool runOneJob(uint32_t worker);
+	void workerLoop(uint32_t worker);
+};
+
+}
@@ -1,78 +1,249 @@
 #include "lve_model.hpp"
 #include "lve_device.hpp"
+#include "lve_upload_context.hpp"
 #include <cstddef>
 #include <cstdint>
 #include <cassert>
 #include <cstring>
+#include <algorithm>
+#include <cmath>
 #include <vector>
 #include <vulkan/vulkan_core.h>
+#include <glm/gtc/packing.hpp>
 
 namespace lve{
-	LveModel::LveModel(LveDevice &device, const std::vector<Vertex> &vertices) : lveDevice(device){
+	LveModel::LveModel(LveDevice &device, const std::vector<Vertex> &vertices, VertexLayout layout) : lveDevice(device), layout(layout){
 		createVertexBuffers(vertices);
+		lveDevice.uploadContext().submit();
+	}
+
+	LveModel::LveModel(LveDevice &device, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, VertexLayout layout) : lveDevice(device), layout(layout){
+		createVertexBuffers(vertices);
+		createIndexBuffer(indices);
+		// both staged copies go out in one batch, nothing is submitted if they were written directly
+		lveDevice.uploadContext().submit();
+	}
+
+	LveModel::LveModel(LveDevice &device, VkBuffer vertexBuffer, LveAllocation vertexBufferMemory, uint32_t vertexCount)
+		: lveDevice(device), vertexBuffer(vertexBuffer), vertexBufferMemory(vertexBufferMemory), vertexCount(vertexCount), layout(VertexLayout::Float32){
+		assert(vertexCount >= 3 && "Vertex count must be at least 3");
 	}
 
 	LveModel::~LveModel(){
 		vkDestroyBuffer(lveDevice.device(), vertexBuffer, nullptr);
-		vkFreeMemory(lveDevice.device(), vertexBufferMemory, nullptr);
+		lveDevice.freeMemory(vertexBufferMemory);
+		if(indexBuffer != VK_NULL_HANDLE){
+			vkDestroyBuffer(lveDevice.device(), indexBuffer, nullptr);
+			lveDevice.freeMemory(indexBufferMemory);
+		}
 	}
 
 	void LveModel::createVertexBuffers(const std::vector<Vertex> &vertices){
 		// count vertices 
 		vertexCount = static_cast<uint32_t>(vertices.size());
-		assert(vertexCount >= 3 && "Vertex count must me at least 3");
-		// calculate buffer size
-		VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
+		assert(vertexCount >= 3 && "Vertex count must be at least 3");
+		// pack and calculate buffer size
+		std::vector<uint8_t> vertexData = encodeVertices(vertices);
+		VkDeviceSize bufferSize = vertexData.size();
 		// create buffer
+		createDeviceLocalBuffer(vertexData.data(), bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexBuffer, vertexBufferMemory);
+	}
+
+	void LveModel::createIndexBuffer(const std::vector<uint32_t> &indices){
+		indexCount = static_cast<uint32_t>(indices.size());
+		if(indexCount == 0){
+			return;
+		}
+		assert(indexCount % 3 == 0 && "Index count must be a multiple of 3");
+
+		// 16 bit indices halve the buffer whenever every vertex is addressable with them
+		bool use16 = vertexCount <= UINT16_MAX;
+		indexType = use16 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+		if(!use16){
+			createDeviceLocalBuffer(indices.data(), indexCount * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexBuffer, indexBufferMemory);
+			return;
+		}
+
+		std::vector<uint16_t> shortIndices(indexCount);
+		for(uint32_t i = 0; i < indexCount; i++){
+			assert(indices[i] < vertexCount && "Index out of range");
+			shortIndices[i] = static_cast<uint16_t>(indices[i]);
+		}
+		createDeviceLocalBuffer(shortIndices.data(), indexCount * sizeof(uint16_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexBuffer, indexBufferMemory);
+	}
+
+	void LveModel::createDeviceLocalBuffer(const void *data, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer &buffer, LveAllocation &memory){
+		if(lveDevice.hasHostVisibleDeviceLocalMemory()){
+			// the large heap the device found, the first type with these flags can be the 256MB BAR window
+			lveDevice.createBuffer(
+				size,
+				usage,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				buffer,
+				memory,
+				lveDevice.getHostVisibleDeviceLocalMemoryType()
+			);
+			// host visible blocks are persistently mapped by the allocator
+			memcpy(memory.mapped, data, static_cast<size_t>(size));
+			return;
+		}
+
+		VkBuffer stagingBuffer;
+		LveAllocation stagingBufferMemory;
+		lveDevice.createBuffer(
+			size,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			stagingBuffer,
+			stagingBufferMemory
+		);
+		memcpy(stagingBufferMemory.mapped, data, static_cast<size_t>(size));
+
 		lveDevice.createBuffer(
-			bufferSize, 
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 
-			vertexBuffer, 
-			vertexBufferMemory
+			size,
+			usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			buffer,
+			memory
 		);
-		// memory mapping
-		void *data;
-		vkMapMemory(lveDevice.device(), vertexBufferMemory, 0, bufferSize, 0, &data);
-		// memory copy
-		memcpy(data, vertices.data(), static_cast<size_t>(bufferSize));
-		// unmap
-		vkUnmapMemory(lveDevice.device(), vertexBufferMemory);
+
+		// recorded only, the constructor submits once the model's last copy is in. The batch ends with a barrier,
+		// so draws submitted after it on the same queue see the data
+		auto &uploadContext = lveDevice.uploadContext();
+		uploadContext.copyBuffer(stagingBuffer, buffer, size);
+		uploadContext.releaseAfterUpload(stagingBuffer, stagingBufferMemory);
+	}
+
+	std::vector<uint8_t> LveModel::encodeVertices(const std::vector<Vertex> &vertices){
+		std::vector<uint8_t> out;
+		if(layout == VertexLayout::Float32){
+			out.resize(sizeof(Vertex) * vertices.size());
+			memcpy(out.data(), vertices.data(), out.size());
+			return out;
+		}
+
+		// map the bounds to [-1, 1], flat axes still need a non zero scale
+		glm::vec2 minPos = vertices[0].position, maxPos = vertices[0].position;
+		for(auto &vertex : vertices){
+			minPos = glm::min(minPos, vertex.position);
+			maxPos = glm::max(maxPos, vertex.position);
+		}
+		decodeOffset = (minPos + maxPos) * .5f;
+		decodeScale = glm::max((maxPos - minPos) * .5f, glm::vec2{1e-6f});
+
+		out.resize(sizeof(PackedVertex) * vertices.size());
+		double squaredError = 0.0;
+		for(size_t i = 0; i < vertices.size(); i++){
+			PackedVertex packed{};
+			glm::vec2 q = glm::clamp((vertices[i].position - decodeOffset) / decodeScale, -1.f, 1.f);
+			glm::vec2 decoded;
+			for(int k = 0; k < 2; k++){
+				if(layout == VertexLayout::Half){
+					packed.position[k] = glm::packHalf1x16(q[k]);
+					decoded[k] = glm::unpackHalf1x16(packed.position[k]);
+				}
+				else{
+					packed.position[k] = glm::packSnorm1x16(q[k]);
+					decoded[k] = glm::unpackSnorm1x16(packed.position[k]);
+				}
+			}
+			float error = glm::distance(decoded * decodeScale + decodeOffset, vertices[i].position);
+			quantizationError.maxPosition = std::max(quantizationError.maxPosition, error);
+			squaredError += double(error) * error;
+
+			for(int k = 0; k < 3; k++){
+				packed.color[k] = glm::packUnorm1x8(vertices[i].color[k]);
+				quantizationError.maxColor = std::max(quantizationError.maxColor, std::abs(glm::unpackUnorm1x8(packed.color[k]) - vertices[i].color[k]));
+			}
+			packed.color[3] = 255;
+
+			memcpy(out.data() + i * sizeof(PackedVertex), &packed, sizeof(PackedVertex));
+		}
+		quantizationError.rmsPosition = static_cast<float>(std::sqrt(squaredError / vertices.size()));
+		return out;
 	}
 
-	void LveModel::draw(VkCommandBuffer commandBuffer){
-		vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+	void LveModel::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t firstInstance){
+		if(isIndexed()){
+			vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, 0, 0, firstInstance);
+		}
+		else{
+			vkCmdDraw(commandBuffer, vertexCount, instanceCount, 0, firstInstance);
+		}
 	}
 
 	void LveModel::bind(VkCommandBuffer commandBuffer){
 		VkBuffer buffers[] = {vertexBuffer};
 		VkDeviceSize offsets[] = {0};
 		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+		if(isIndexed()){
+			vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, indexType);
+		}
 	}
 
-	std::vector<VkVertexInputBindingDescription> LveModel::Vertex::getBindingDescriptions(){
-		std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+	std::vector<VkVertexInputBindingDescription> LveModel::Vertex::getBindingDescriptions(VertexLayout layout){
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions(2);
 		bindingDescriptions[0] = {
 			.binding = 0,
-			.stride = sizeof(Vertex),
+			.stride = static_cast<uint32_t>(layout == VertexLayout::Float32 ? sizeof(Vertex) : sizeof(PackedVertex)),
 			.inputRate = VK_VERTEX_INPUT_RATE_VERTEX
 		};
+		bindingDescriptions[1] = {
+			.binding = 1,
+			.stride = sizeof(InstanceData),
+			.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE
+		};
 		return bindingDescriptions;
 	}
 
-	std::vector<VkVertexInputAttributeDescription> LveModel::Vertex::getAttributeDescriptions(){
+	std::vector<VkVertexInputAttributeDescription> LveModel::Vertex::getAttributeDescriptions(VertexLayout layout){
+		// the shader reads floats for every layout, only the formats change
+		bool packed = layout != VertexLayout::Float32;
+		VkFormat positionFormat = VK_FORMAT_R32G32_SFLOAT;
+		if(layout == VertexLayout::Half){
+			positionFormat = VK_FORMAT_R16G16_SFLOAT;
+		}
+		else if(layout == VertexLayout::Snorm16){
+			positionFormat = VK_FORMAT_R16G16_SNORM;
+		}
+
 		return {
 			{
 				.location = 0,
 				.binding = 0,
-				.format = VK_FORMAT_R32G32_SFLOAT,
-				.offset = offsetof(Vertex, position),
+				.format = positionFormat,
+				.offset = static_cast<uint32_t>(packed ? offsetof(PackedVertex, position) : offsetof(Vertex, position)),
 			},
 			{
 				.location = 1,
 				.binding = 0,
+				.format = packed ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R32G32B32_SFLOAT,
+				.offset = static_cast<uint32_t>(packed ? offsetof(PackedVertex, color) : offsetof(Vertex, color)),
+			},
+			// mat2 takes one location per column
+			{
+				.location = 2,
+				.binding = 1,
+				.format = VK_FORMAT_R32G32_SFLOAT,
+				.offset = offsetof(InstanceData, transform),
+			},
+			{
+				.location = 3,
+				.binding = 1,
+				.format = VK_FORMAT_R32G32_SFLOAT,
+				.offset = offsetof(InstanceData, transform) + sizeof(glm::vec2),
+			},
+			{
+				.location = 4,
+				.binding = 1,
+				.format = VK_FORMAT_R32G32_SFLOAT,
+				.offset = offsetof(InstanceData, offset),
+			},
+			{
+				.location = 5,
+				.binding = 1,
 				.format = VK_FORMAT_R32G32B32_SFLOAT,
-				.offset = offsetof(Vertex, color),
+				.offset = offsetof(InstanceData, color),
 			}
 		};
 	}
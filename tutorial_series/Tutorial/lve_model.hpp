@@ -15,15 +15,48 @@ namespace lve {
 class LveModel {
 public:
 
+	// how vertices are stored in the vertex buffer
+	enum class VertexLayout : uint32_t {
+		Float32,	// Vertex as is, 20 bytes
+		Half,		// PackedVertex with half float positions, 8 bytes
+		Snorm16,	// PackedVertex with 16 bit snorm positions, 8 bytes
+	};
+	static constexpr uint32_t VERTEX_LAYOUT_COUNT = 3;
+
 	struct Vertex{
 		glm::vec2 position;
 		glm::vec3 color;
 
-		static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
-		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+		// binding 0 is per vertex, binding 1 per instance (InstanceData)
+		static std::vector<VkVertexInputBindingDescription> getBindingDescriptions(VertexLayout layout = VertexLayout::Float32);
+		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(VertexLayout layout = VertexLayout::Float32);
+	};
+
+	// positions mapped from the model bounds to [-1, 1], decoded by folding getDecodeScale/Offset into the instance transform
+	struct PackedVertex{
+		uint16_t position[2];	// half or snorm16
+		uint8_t color[4];		// unorm8, a is padding
+	};
+
+	// difference between the vertices passed in and what the GPU decodes
+	struct QuantizationError{
+		float maxPosition;
+		float rmsPosition;
+		float maxColor;
 	};
 
-	LveModel(LveDevice &device, const std::vector<Vertex> &vertices);
+	// per object data for instanced draws
+	struct InstanceData{
+		glm::mat2 transform{1.f};
+		glm::vec2 offset;
+		glm::vec3 color;
+	};
+
+	LveModel(LveDevice &device, const std::vector<Vertex> &vertices, VertexLayout layout = VertexLayout::Float32);
+	// indexed model, the indices are uploaded to device local memory through the device's upload context
+	LveModel(LveDevice &device, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, VertexLayout layout = VertexLayout::Float32);
+	// adopts a device local vertex buffer filled on the GPU in the Float32 layout, the model destroys it
+	LveModel(LveDevice &device, VkBuffer vertexBuffer, LveAllocation vertexBufferMemory, uint32_t vertexCount);
 	~LveModel();
 
 	// deleting copy to prevent vulkan object cloning
@@ -31,16 +64,38 @@ public:
 	LveModel operator=(const LveModel&) = delete;
 
 	void bind(VkCommandBuffer commandBuffer);
-	void draw(VkCommandBuffer commandBuffer);
+	void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+
+	VertexLayout getLayout() const { return layout; }
+	bool isIndexed() const { return indexCount > 0; }
+	VkIndexType getIndexType() const { return indexType; }
+	// stored position * decodeScale + decodeOffset = model space position
+	glm::vec2 getDecodeScale() const { return decodeScale; }
+	glm::vec2 getDecodeOffset() const { return decodeOffset; }
+	const QuantizationError &getQuantizationError() const { return quantizationError; }
 
 private:
 	LveDevice& lveDevice; // device reference
 	// vertex memory
 	VkBuffer vertexBuffer;
-	VkDeviceMemory vertexBufferMemory;
+	LveAllocation vertexBufferMemory;
 	uint32_t vertexCount;
+	// index memory, only created for indexed models
+	VkBuffer indexBuffer = VK_NULL_HANDLE;
+	LveAllocation indexBufferMemory{};
+	uint32_t indexCount = 0;
+	VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+	VertexLayout layout;
+	glm::vec2 decodeScale{1.f};
+	glm::vec2 decodeOffset{0.f};
+	QuantizationError quantizationError{};
 
 	void createVertexBuffers(const std::vector<Vertex> &vertices);
+	void createIndexBuffer(const std::vector<uint32_t> &indices);
+	// device local buffer filled with `data`, written directly when the device allows it, otherwise staged
+	// into the upload context's open batch without submitting it
+	void createDeviceLocalBuffer(const void *data, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer &buffer, LveAllocation &memory);
+	std::vector<uint8_t> encodeVertices(const std::vector<Vertex> &vertices);
 
 };
 
@@ -0,0 +1,287 @@
+#include "lve_offscreen_target.hpp"
+#include "lve_profiler.hpp"
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace lve {
+
+LveOffscreenTarget::LveOffscreenTarget(LveDevice &device, VkExtent2D extent) : device{device}, extent{extent}{
+	if(extent.width == 0 || extent.height == 0){
+		throw std::runtime_error("Offscreen target needs a non zero extent");
+	}
+	// sRGB like the swap chain would pick, so read back pixels match what a window shows
+	colorFormat = device.findSupportedFormat(
+		{VK_FORMAT_R8G8B8A8_SRGB, VK_FORMAT_B8G8R8A8_SRGB},
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT);
+	depthFormat = device.findSupportedFormat(
+		{VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+
+	createRenderPass();
+	createFrames();
+}
+
+LveOffscreenTarget::~LveOffscreenTarget(){
+	for(auto &frame : frames){
+		vkDestroyFence(device.device(), frame.fence, nullptr);
+		vkDestroyFramebuffer(device.device(), frame.framebuffer, nullptr);
+		vkDestroyImageView(device.device(), frame.depthView, nullptr);
+		vkDestroyImage(device.device(), frame.depthImage, nullptr);
+		device.freeMemory(frame.depthMemory);
+		vkDestroyImageView(device.device(), frame.colorView, nullptr);
+		vkDestroyImage(device.device(), frame.colorImage, nullptr);
+		device.freeMemory(frame.colorMemory);
+	}
+	vkDestroyRenderPass(device.device(), renderPass, nullptr);
+}
+
+VkResult LveOffscreenTarget::acquireNextImage(uint32_t *imageIndex){
+	LVE_PROFILE_ZONE("wait for frame fence");
+	vkWaitForFences(device.device(), 1, &frames[currentFrame].fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+	*imageIndex = currentFrame;
+	return VK_SUCCESS;
+}
+
+VkResult LveOffscreenTarget::submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex){
+	// nothing to wait for or signal, the image belongs to this frame alone
+	VkSubmitInfo submitInfo{
+		.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+		.commandBufferCount = 1,
+		.pCommandBuffers = buffers,
+	};
+
+	vkResetFences(device.device(), 1, &frames[*imageIndex].fence);
+	{
+		LVE_PROFILE_ZONE("queue submit");
+		std::lock_guard<std::mutex> lock(device.queueMutex());
+		if(vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, frames[*imageIndex].fence) != VK_SUCCESS){
+			throw std::runtime_error("Failed to submit offscreen command buffer");
+		}
+	}
+
+	latestImage = *imageIndex;
+	currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+	return VK_SUCCESS;
+}
+
+void LveOffscreenTarget::writeLatestImage(const std::string &path){
+	if(latestImage == UINT32_MAX){
+		throw std::runtime_error("No offscreen frame rendered yet");
+	}
+	Frame &frame = frames[latestImage];
+	vkWaitForFences(device.device(), 1, &frame.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+	VkDeviceSize size = VkDeviceSize(extent.width) * extent.height * 4;
+	VkBuffer buffer;
+	LveAllocation memory;
+	device.createBuffer(
+		size,
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		buffer,
+		memory);
+
+	VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+	// the render pass left the image in TRANSFER_SRC_OPTIMAL, only its writes need to become visible
+	VkImageMemoryBarrier imageBarrier{
+		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+		.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.image = frame.colorImage,
+		.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1},
+	};
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+	VkBufferImageCopy region{
+		.bufferOffset = 0,
+		.bufferRowLength = 0,
+		.bufferImageHeight = 0,
+		.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+		.imageOffset = {0, 0, 0},
+		.imageExtent = {extent.width, extent.height, 1},
+	};
+	vkCmdCopyImageToBuffer(commandBuffer, frame.colorImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, &region);
+
+	VkBufferMemoryBarrier bufferBarrier{
+		.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.buffer = buffer,
+		.offset = 0,
+		.size = size,
+	};
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+		0, 0, nullptr, 1, &bufferBarrier, 0, nullptr);
+	device.endSingleTimeCommands(commandBuffer);
+
+	FILE *file = fopen(path.c_str(), "wb");
+	if(file == nullptr){
+		vkDestroyBuffer(device.device(), buffer, nullptr);
+		device.freeMemory(memory);
+		throw std::runtime_error("Failed to open image file " + path);
+	}
+	fprintf(file, "P6\n%u %u\n255\n", extent.width, extent.height);
+	// PPM is plain RGB, drop alpha and undo the BGRA order if that is what the device gave us
+	bool bgra = colorFormat == VK_FORMAT_B8G8R8A8_SRGB;
+	const uint8_t *pixels = static_cast<const uint8_t*>(memory.mapped);
+	std::vector<uint8_t> row(3 * extent.width);
+	for(uint32_t y = 0; y < extent.height; y++){
+		for(uint32_t x = 0; x < extent.width; x++){
+			const uint8_t *pixel = pixels + 4 * (size_t(y) * extent.width + x);
+			row[3 * x] = pixel[bgra ? 2 : 0];
+			row[3 * x + 1] = pixel[1];
+			row[3 * x + 2] = pixel[bgra ? 0 : 2];
+		}
+		fwrite(row.data(), 1, row.size(), file);
+	}
+	bool failed = fclose(file) != 0;
+
+	vkDestroyBuffer(device.device(), buffer, nullptr);
+	device.freeMemory(memory);
+	if(failed){
+		throw std::runtime_error("Failed to write image file " + path);
+	}
+}
+
+void LveOffscreenTarget::createRenderPass(){
+	// laid out like the swap chain pass, only the color format and the final layout differ
+	VkAttachmentDescription colorAttachment{
+		.format = colorFormat,
+		.samples = VK_SAMPLE_COUNT_1_BIT,
+		.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+		.storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+		.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+		.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+	};
+	VkAttachmentDescription depthAttachment{
+		.format = depthFormat,
+		.samples = VK_SAMPLE_COUNT_1_BIT,
+		.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+		.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+		.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+		.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+	};
+
+	VkAttachmentReference colorAttachmentRef{
+		.attachment = 0,
+		.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+	};
+	VkAttachmentReference depthAttachmentRef{
+		.attachment = 1,
+		.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+	};
+
+	VkSubpassDescription subpass{
+		.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+		.colorAttachmentCount = 1,
+		.pColorAttachments = &colorAttachmentRef,
+		.pDepthStencilAttachment = &depthAttachmentRef,
+	};
+
+	VkSubpassDependency dependency{
+		.srcSubpass = VK_SUBPASS_EXTERNAL,
+		.dstSubpass = 0,
+		.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+		.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+		.srcAccessMask = 0,
+		.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+	};
+
+	std::array<VkAttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
+	VkRenderPassCreateInfo renderPassInfo{
+		.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+		.attachmentCount = static_cast<uint32_t>(attachments.size()),
+		.pAttachments = attachments.data(),
+		.subpassCount = 1,
+		.pSubpasses = &subpass,
+		.dependencyCount = 1,
+		.pDependencies = &dependency,
+	};
+
+	if(vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS){
+		throw std::runtime_error("Failed to create offscreen render pass");
+	}
+}
+
+void LveOffscreenTarget::createImage(VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect, VkImage &image, LveAllocation &memory, VkImageView &view){
+	VkImageCreateInfo imageInfo{
+		.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+		.imageType = VK_IMAGE_TYPE_2D,
+		.format = format,
+		.extent = {extent.width, extent.height, 1},
+		.mipLevels = 1,
+		.arrayLayers = 1,
+		.samples = VK_SAMPLE_COUNT_1_BIT,
+		.tiling = VK_IMAGE_TILING_OPTIMAL,
+		.usage = usage,
+		.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+	};
+	device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory);
+
+	VkImageViewCreateInfo viewInfo{
+		.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+		.image = image,
+		.viewType = VK_IMAGE_VIEW_TYPE_2D,
+		.format = format,
+		.subresourceRange = {aspect, 0, 1, 0, 1},
+	};
+	if(vkCreateImageView(device.device(), &viewInfo, nullptr, &view) != VK_SUCCESS){
+		throw std::runtime_error("Failed to create offscreen image view");
+	}
+}
+
+void LveOffscreenTarget::createFrames(){
+	frames.resize(MAX_FRAMES_IN_FLIGHT);
+	for(auto &frame : frames){
+		createImage(colorFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_IMAGE_ASPECT_COLOR_BIT,
+			frame.colorImage, frame.colorMemory, frame.colorView);
+		createImage(depthFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_IMAGE_ASPECT_DEPTH_BIT,
+			frame.depthImage, frame.depthMemory, frame.depthView);
+
+		std::array<VkImageView, 2> attachments = {frame.colorView, frame.depthView};
+		VkFramebufferCreateInfo framebufferInfo{
+			.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+			.renderPass = renderPass,
+			.attachmentCount = static_cast<uint32_t>(attachments.size()),
+			.pAttachments = attachments.data(),
+			.width = extent.width,
+			.height = extent.height,
+			.layers = 1,
+		};
+		if(vkCreateFramebuffer(device.device(), &framebufferInfo, nullptr, &frame.framebuffer) != VK_SUCCESS){
+			throw std::runtime_error("Failed to create offscreen framebuffer");
+		}
+
+		// signaled so the first wait on every frame returns right away
+		VkFenceCreateInfo fenceInfo{
+			.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+			.flags = VK_FENCE_CREATE_SIGNALED_BIT,
+		};
+		if(vkCreateFence(device.device(), &fenceInfo, nullptr, &frame.fence) != VK_SUCCESS){
+			throw std::runtime_error("Failed to create offscreen frame fence");
+		}
+	}
+}
+
+}
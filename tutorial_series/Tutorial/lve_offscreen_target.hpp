@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "lve_allocator.hpp"
+#include "lve_device.hpp"
+#include "lve_swap_chain.hpp"
+
+namespace lve {
+
+// stands in for the swap chain when there is no window. Every frame in flight owns a color and a depth
+// image, the image index handed out is the frame index, and frames are only fenced, never presented.
+// The color images end up in TRANSFER_SRC_OPTIMAL so finished frames can be read back.
+class LveOffscreenTarget {
+public:
+	static constexpr int MAX_FRAMES_IN_FLIGHT = LveSwapChain::MAX_FRAMES_IN_FLIGHT;
+
+	LveOffscreenTarget(LveDevice &device, VkExtent2D extent);
+	~LveOffscreenTarget();
+
+	// deleting copy constructors to prevent vulkan object cloning
+	LveOffscreenTarget(const LveOffscreenTarget&) = delete;
+	LveOffscreenTarget operator=(const LveOffscreenTarget&) = delete;
+
+	VkFramebuffer getFrameBuffer(int index) { return frames[index].framebuffer; }
+	VkRenderPass getRenderPass() { return renderPass; }
+	size_t imageCount() { return frames.size(); }
+	VkFormat getImageFormat() { return colorFormat; }
+	VkExtent2D getExtent() { return extent; }
+
+	// waits until the frame's previous submit is done, same contract as LveSwapChain
+	VkResult acquireNextImage(uint32_t *imageIndex);
+	VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
+
+	// blocks until the last submitted frame finished and writes it as a binary PPM
+	void writeLatestImage(const std::string &path);
+
+private:
+	struct Frame {
+		VkImage colorImage = VK_NULL_HANDLE;
+		LveAllocation colorMemory{};
+		VkImageView colorView = VK_NULL_HANDLE;
+		VkImage depthImage = VK_NULL_HANDLE;
+		LveAllocation depthMemory{};
+		VkImageView depthView = VK_NULL_HANDLE;
+		VkFramebuffer framebuffer = VK_NULL_HANDLE;
+		VkFence fence = VK_NULL_HANDLE;
+	};
+
+	LveDevice &device;
+	VkExtent2D extent;
+	VkFormat colorFormat;
+	VkFormat depthFormat;
+	VkRenderPass renderPass = VK_NULL_HANDLE;
+	std::vector<Frame> frames;
+	uint32_t currentFrame = 0;
+	uint32_t latestImage = UINT32_MAX;	// nothing submitted yet
+
+	void createRenderPass();
+	void createImage(VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect, VkImage &image, LveAllocation &memory, VkImageView &view);
+	void createFrames();
+};
+
+}
@@ -0,0 +1,126 @@
+#include "lve_parallel_recorder.hpp"
+#include "lve_device.hpp"
+#include "lve_swap_chain.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace lve {
+
+LveParallelRecorder::LveParallelRecorder(LveDevice &device, LveJobSystem &jobSystem) : lveDevice(device), jobSystem(jobSystem), taskCount(jobSystem.getThreadCount()){
+	createCommandPools();
+}
+
+LveParallelRecorder::~LveParallelRecorder(){
+	// destroying a pool frees its command buffers
+	for(auto &frame : taskFrames){
+		for(auto &taskFrame : frame){
+			vkDestroyCommandPool(lveDevice.device(), taskFrame.commandPool, nullptr);
+		}
+	}
+}
+
+void LveParallelRecorder::createCommandPools(){
+	taskFrames.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+	for(auto &frame : taskFrames){
+		frame.resize(taskCount);
+		for(auto &taskFrame : frame){
+			// reset as a whole once per frame instead of per command buffer
+			VkCommandPoolCreateInfo poolInfo{
+				.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+				.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+				.queueFamilyIndex = lveDevice.findPhysicalQueueFamilies().graphicsFamily,
+			};
+
+			if(vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &taskFrame.commandPool) != VK_SUCCESS){
+				throw std::runtime_error("Failed to create recording command pool");
+			}
+		}
+	}
+}
+
+void LveParallelRecorder::beginFrame(int frameIndex, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent){
+	this->frameIndex = frameIndex;
+	this->renderPass = renderPass;
+	this->framebuffer = framebuffer;
+	this->extent = extent;
+
+	for(auto &taskFrame : taskFrames[frameIndex]){
+		vkResetCommandPool(lveDevice.device(), taskFrame.commandPool, 0);
+		taskFrame.usedCommandBuffers = 0;
+	}
+}
+
+VkCommandBuffer LveParallelRecorder::acquireCommandBuffer(TaskFrame &taskFrame){
+	if(taskFrame.usedCommandBuffers == taskFrame.commandBuffers.size()){
+		VkCommandBufferAllocateInfo allocInfo{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+			.commandPool = taskFrame.commandPool,
+			.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+			.commandBufferCount = 1,
+		};
+
+		VkCommandBuffer commandBuffer;
+		if(vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS){
+			throw std::runtime_error("Failed to allocate secondary command buffer");
+		}
+		taskFrame.commandBuffers.push_back(commandBuffer);
+	}
+	return taskFrame.commandBuffers[taskFrame.usedCommandBuffers++];
+}
+
+void LveParallelRecorder::record(VkCommandBuffer primaryCommandBuffer, uint32_t usedTasks, const std::function<void(VkCommandBuffer, uint32_t)> &fn){
+	usedTasks = std::min(usedTasks, taskCount);
+	recorded.resize(usedTasks);
+
+	jobSystem.parallelFor(usedTasks, 1, [&](uint32_t task, uint32_t){
+		auto commandBuffer = acquireCommandBuffer(taskFrames[frameIndex][task]);
+
+		VkCommandBufferInheritanceInfo inheritanceInfo{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+			.renderPass = renderPass,
+			.subpass = 0,
+			.framebuffer = framebuffer,
+		};
+		VkCommandBufferBeginInfo beginInfo{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+			.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+			.pInheritanceInfo = &inheritanceInfo,
+		};
+		if(vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS){
+			throw std::runtime_error("Failed to begin secondary command buffer");
+		}
+
+		// dynamic state is not inherited from the primary
+		VkViewport viewPort{
+			.x = 0.0f,
+			.y = 0.0f,
+			.width = static_cast<float>(extent.width),
+			.height = static_cast<float>(extent.height),
+			.minDepth = 0.0f,
+			.maxDepth = 1.0f
+		};
+		VkRect2D scissor{
+			.offset = {0, 0},
+			.extent = extent
+		};
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewPort);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		fn(commandBuffer, task);
+
+		if(vkEndCommandBuffer(commandBuffer) != VK_SUCCESS){
+			throw std::runtime_error("Failed to record secondary command buffer");
+		}
+		recorded[task] = commandBuffer;
+	});
+
+	if(!recorded.empty()){
+		vkCmdExecuteCommands(primaryCommandBuffer, static_cast<uint32_t>(recorded.size()), recorded.data());
+	}
+}
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "lve_device.hpp"
+#include "lve_job_system.hpp"
+
+namespace lve {
+
+// records secondary command buffers for the current render pass as jobs, one task per job system
+// thread. Every task owns one command pool per frame in flight, only one job records into it at a time.
+class LveParallelRecorder {
+public:
+	LveParallelRecorder(LveDevice &device, LveJobSystem &jobSystem);
+	~LveParallelRecorder();
+
+	// deleting copy constructors to prevent vulkan object cloning
+	LveParallelRecorder(const LveParallelRecorder&) = delete;
+	LveParallelRecorder operator=(const LveParallelRecorder&) = delete;
+
+	uint32_t getTaskCount() const { return taskCount; }
+
+	// resets the frame's pools, only call once its fence signaled and the render pass was begun
+	// with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+	void beginFrame(int frameIndex, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent);
+
+	// calls fn(commandBuffer, task) for tasks [0, usedTasks) with a secondary command buffer that already
+	// has viewport and scissor set, then executes them on the primary in task order. Tasks past usedTasks
+	// have nothing to draw, they record no command buffer at all.
+	void record(VkCommandBuffer primaryCommandBuffer, uint32_t usedTasks, const std::function<void(VkCommandBuffer, uint32_t)> &fn);
+
+private:
+	struct TaskFrame {
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+		std::vector<VkCommandBuffer> commandBuffers; // grows when a frame calls record() more often
+		uint32_t usedCommandBuffers = 0;
+	};
+
+	LveDevice &lveDevice;
+	LveJobSystem &jobSystem;
+	uint32_t taskCount;
+	std::vector<std::vector<TaskFrame>> taskFrames; // [frame in flight][task]
+	std::vector<VkCommandBuffer> recorded; // kept to avoid per frame allocations
+	int frameIndex = 0;
+	VkRenderPass renderPass = VK_NULL_HANDLE;
+	VkFramebuffer framebuffer = VK_NULL_HANDLE;
+	VkExtent2D extent{};
+
+	void createCommandPools();
+	VkCommandBuffer acquireCommandBuffer(TaskFrame &taskFrame);
+};
+
+}
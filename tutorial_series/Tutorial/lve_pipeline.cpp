@@ -68,8 +68,8 @@ void LvePipeline::createGraphicsPipeline(const std::string& vertFilePath, const
 		}
 	};
 
-	auto bindingDescriptions = LveModel::Vertex::getBindingDescriptions();
-	auto attributeDescriptions = LveModel::Vertex::getAttributeDescriptions();
+	auto& bindingDescriptions = configInfo.bindingDescriptions;
+	auto& attributeDescriptions = configInfo.attributeDescriptions;
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
 		.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size()),
@@ -97,7 +97,7 @@ void LvePipeline::createGraphicsPipeline(const std::string& vertFilePath, const
 		.basePipelineIndex = -1,
 	};
 
-	if(vkCreateGraphicsPipelines(lveDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS){
+	if(vkCreateGraphicsPipelines(lveDevice.device(), lveDevice.pipelineCache(), 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS){
 		throw std::runtime_error("failed to crate graphics pipeline");
 	}
 
@@ -207,6 +207,9 @@ void LvePipeline::defaultPipelineConfngInfo(PipelineConfigInfo& configInfo){
 		.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStateEnables.size()),
 		.pDynamicStates = configInfo.dynamicStateEnables.data(),
 	};
+	// vertex input
+	configInfo.bindingDescriptions = LveModel::Vertex::getBindingDescriptions();
+	configInfo.attributeDescriptions = LveModel::Vertex::getAttributeDescriptions();
 }
 
 void LvePipeline::bind(VkCommandBuffer commandBuffer){
@@ -13,6 +13,8 @@ struct PipelineConfigInfo {
 	PipelineConfigInfo(const PipelineConfigInfo&) = delete;
 	PipelineConfigInfo operator=(const PipelineConfigInfo&) = delete;
 
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
 	VkPipelineViewportStateCreateInfo viewportInfo;
 	VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo;
 	VkPipelineRasterizationStateCreateInfo rasterizationInfo;
@@ -43,6 +45,9 @@ public:
 	// default config
 	static void defaultPipelineConfngInfo(PipelineConfigInfo &);
 
+	// helper to read the compiled shader files
+	static std::vector<char> readFile(const std::string& filePath);
+
 
 private:
 	LveDevice& lveDevice; // allowed only because implicitly devices must outive pipelines
@@ -51,9 +56,6 @@ private:
 	VkShaderModule vertShaderModule;
 	VkShaderModule fragShaderModule;
 
-	// helper to read the compiled shader files
-	static std::vector<char> readFile(const std::string& filePath);
-
 	// simple pipeline createion
 	void createGraphicsPipeline(const std::string& vertFilePath, const std::string& fragFilePath, const PipelineConfigInfo& configInfo);
 
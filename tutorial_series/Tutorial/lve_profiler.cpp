@@ -0,0 +1,245 @@
+#include "lve_profiler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace lve {
+
+namespace {
+
+// fields are atomics so an exporter reading a slot that is being overwritten is only stale, never undefined
+struct Event {
+	std::atomic<const char*> name{nullptr};
+	std::atomic<uint64_t> start{0};
+	std::atomic<uint64_t> end{0};
+};
+
+}
+
+// written by one thread only, head counts every event ever pushed
+struct LveProfiler::Track {
+	// allocated by the first push, threads that never record during a capture don't pay for a ring.
+	// Published before head moves, so readers that saw a non zero head also see the ring.
+	std::atomic<Event*> events{nullptr};
+	std::atomic<uint64_t> head{0};
+	std::atomic<const char*> name{nullptr};
+	uint32_t id = 0;
+	bool isThread = true;
+
+	~Track(){
+		delete[] events.load(std::memory_order_relaxed);
+	}
+
+	void push(const char *eventName, uint64_t start, uint64_t end){
+		Event *ring = events.load(std::memory_order_relaxed);
+		if(ring == nullptr){
+			ring = new Event[LveProfiler::RING_CAPACITY];
+			events.store(ring, std::memory_order_release);
+		}
+		uint64_t index = head.load(std::memory_order_relaxed);
+		Event &event = ring[index % LveProfiler::RING_CAPACITY];
+		event.name.store(eventName, std::memory_order_relaxed);
+		event.start.store(start, std::memory_order_relaxed);
+		event.end.store(end, std::memory_order_relaxed);
+		head.store(index + 1, std::memory_order_release);
+	}
+};
+
+namespace {
+
+using Track = LveProfiler::Track;
+
+struct ProfilerState {
+	std::atomic<bool> capturing{false};
+	std::mutex mutex;	// guards the lists, never taken while recording into an existing track
+	std::vector<std::unique_ptr<Track>> tracks;
+	std::unordered_set<std::string> names;
+};
+
+// function local so zones in other static initializers find it constructed
+ProfilerState &getState(){
+	static ProfilerState state;
+	return state;
+}
+
+thread_local Track *threadTrack = nullptr;
+
+Track &getThreadTrack(){
+	if(threadTrack == nullptr){
+		auto &state = getState();
+		std::lock_guard<std::mutex> lock(state.mutex);
+		state.tracks.push_back(std::make_unique<Track>());
+		threadTrack = state.tracks.back().get();
+		threadTrack->id = static_cast<uint32_t>(state.tracks.size());
+	}
+	return *threadTrack;
+}
+
+Track &getNamedTrack(const char *name){
+	auto &state = getState();
+	std::lock_guard<std::mutex> lock(state.mutex);
+	for(auto &track : state.tracks){
+		if(!track->isThread && track->name.load(std::memory_order_relaxed) == name){
+			return *track;
+		}
+	}
+	state.tracks.push_back(std::make_unique<Track>());
+	auto &track = *state.tracks.back();
+	track.id = static_cast<uint32_t>(state.tracks.size());
+	track.isThread = false;
+	track.name.store(name, std::memory_order_relaxed);
+	return track;
+}
+
+void writeJsonString(FILE *file, const char *text){
+	fputc('"', file);
+	for(const char *c = text; *c != '\0'; c++){
+		// control characters aren't allowed raw in JSON strings, viewers reject the whole file
+		if(static_cast<unsigned char>(*c) < 0x20){
+			fprintf(file, "\\u%04x", static_cast<unsigned char>(*c));
+			continue;
+		}
+		if(*c == '"' || *c == '\\'){
+			fputc('\\', file);
+		}
+		fputc(*c, file);
+	}
+	fputc('"', file);
+}
+
+}
+
+void LveProfiler::startCapture(){
+	getState().capturing.store(true, std::memory_order_relaxed);
+}
+
+void LveProfiler::stopCapture(){
+	getState().capturing.store(false, std::memory_order_relaxed);
+}
+
+bool LveProfiler::isCapturing(){
+	return getState().capturing.load(std::memory_order_relaxed);
+}
+
+uint64_t LveProfiler::now(){
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void LveProfiler::setThreadName(const char *name){
+	getThreadTrack().name.store(name, std::memory_order_relaxed);
+}
+
+const char *LveProfiler::internName(const std::string &name){
+	auto &state = getState();
+	std::lock_guard<std::mutex> lock(state.mutex);
+	// set nodes never move, so the pointer outlives later insertions
+	return state.names.insert(name).first->c_str();
+}
+
+void LveProfiler::record(const char *name, uint64_t start, uint64_t end){
+	getThreadTrack().push(name, start, end);
+}
+
+LveProfiler::Track *LveProfiler::getTrack(const char *name){
+	return &getNamedTrack(name);
+}
+
+void LveProfiler::recordOnTrack(Track *track, const char *name, uint64_t start, uint64_t end){
+	if(isCapturing()){
+		track->push(name, start, end);
+	}
+}
+
+void LveProfiler::writeChromeTrace(const std::string &path){
+	struct ExportedEvent {
+		const char *name;
+		uint64_t start;
+		uint64_t end;
+		uint32_t track;
+	};
+	std::vector<ExportedEvent> events;
+	std::vector<std::pair<uint32_t, const char*>> trackNames;
+
+	{
+		auto &state = getState();
+		std::lock_guard<std::mutex> lock(state.mutex);
+		for(auto &track : state.tracks){
+			trackNames.push_back({track->id, track->name.load(std::memory_order_relaxed)});
+
+			uint64_t head = track->head.load(std::memory_order_acquire);
+			if(head == 0){
+				continue;
+			}
+			Event *ring = track->events.load(std::memory_order_acquire);
+			uint64_t first = head > RING_CAPACITY ? head - RING_CAPACITY : 0;
+			size_t copied = events.size();
+			for(uint64_t index = first; index < head; index++){
+				Event &event = ring[index % RING_CAPACITY];
+				events.push_back({
+					event.name.load(std::memory_order_relaxed),
+					event.start.load(std::memory_order_relaxed),
+					event.end.load(std::memory_order_relaxed),
+					track->id,
+				});
+			}
+
+			// the owner kept recording meanwhile, drop the slots it may have overwritten while they were copied
+			uint64_t newHead = track->head.load(std::memory_order_acquire);
+			if(newHead >= RING_CAPACITY && newHead - RING_CAPACITY + 1 > first){
+				uint64_t overwritten = std::min(newHead - RING_CAPACITY + 1 - first, head - first);
+				events.erase(events.begin() + copied, events.begin() + copied + overwritten);
+			}
+		}
+	}
+
+	FILE *file = fopen(path.c_str(), "w");
+	if(file == nullptr){
+		throw std::runtime_error("Failed to open trace file " + path);
+	}
+
+	uint64_t origin = UINT64_MAX;
+	for(auto &event : events){
+		origin = std::min(origin, event.start);
+	}
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool first = true;
+	for(auto &[id, name] : trackNames){
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", first ? "" : ",\n", id);
+		if(name != nullptr){
+			writeJsonString(file, name);
+		}
+		else{
+			fprintf(file, "\"thread %u\"", id);
+		}
+		fprintf(file, "}}");
+		// keep tracks in creation order instead of alphabetical
+		fprintf(file, ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"sort_index\":%u}}", id, id);
+		first = false;
+	}
+	for(auto &event : events){
+		if(event.name == nullptr || event.end < event.start){
+			continue;
+		}
+		fprintf(file, "%s{\"name\":", first ? "" : ",\n");
+		writeJsonString(file, event.name);
+		fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+			event.track, (event.start - origin) * 1e-3, (event.end - event.start) * 1e-3);
+		first = false;
+	}
+	fprintf(file, "\n]}\n");
+
+	if(fclose(file) != 0){
+		throw std::runtime_error("Failed to write trace file " + path);
+	}
+}
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace lve {
+
+// CPU zone profiler. Zones are written by the thread that ran them into a ring buffer of its own,
+// so recording never locks and only the latest zones of each thread are kept. Rings are allocated by
+// the first zone recorded into them, threads that never run one during a capture cost nothing. While
+// no capture is running a zone costs a single relaxed load. Export is Chrome's trace event JSON, which
+// Perfetto and chrome://tracing open directly.
+//
+// Use the LVE_PROFILE_* macros, building with -DLVE_DISABLE_PROFILER compiles them away.
+class LveProfiler {
+public:
+	// events kept per thread, older ones are overwritten
+	static constexpr uint32_t RING_CAPACITY = 1 << 16;
+
+	// ring buffer of one thread or named track, only handed out as a pointer
+	struct Track;
+
+	class Zone {
+	public:
+		explicit Zone(const char *name) : name{name}, start{isCapturing() ? now() : 0} {}
+		~Zone(){
+			if(start != 0){
+				record(name, start, now());
+			}
+		}
+
+		Zone(const Zone&) = delete;
+		Zone operator=(const Zone&) = delete;
+
+	private:
+		const char *name;
+		uint64_t start;
+	};
+
+	static void startCapture();
+	static void stopCapture();
+	static bool isCapturing();
+
+	// nanoseconds on the trace timeline
+	static uint64_t now();
+	// labels the calling thread's track, `name` has to outlive the profiler
+	static void setThreadName(const char *name);
+	// stores a copy of the name for zones whose name isn't a literal, the pointer stays valid for good
+	static const char *internName(const std::string &name);
+
+	// records a finished zone on the calling thread, names have to outlive the profiler
+	static void record(const char *name, uint64_t start, uint64_t end);
+	// track for zones measured by something other than a CPU thread, e.g. GPU timestamps. Looking it up
+	// locks, so do it once up front, the same name always gives the same track and it lives for good.
+	static Track *getTrack(const char *name);
+	// records onto a track from getTrack without locking, only one thread may add to a given track
+	static void recordOnTrack(Track *track, const char *name, uint64_t start, uint64_t end);
+
+	// every zone still held in the ring buffers, safe while threads keep recording
+	static void writeChromeTrace(const std::string &path);
+};
+
+}
+
+#define LVE_PROFILE_CONCAT_INNER(a, b) a##b
+#define LVE_PROFILE_CONCAT(a, b) LVE_PROFILE_CONCAT_INNER(a, b)
+
+#ifndef LVE_DISABLE_PROFILER
+// times the rest of the enclosing scope
+#define LVE_PROFILE_ZONE(name) ::lve::LveProfiler::Zone LVE_PROFILE_CONCAT(lveProfileZone, __LINE__){name}
+#define LVE_PROFILE_FUNCTION() LVE_PROFILE_ZONE(__func__)
+#define LVE_PROFILE_THREAD(name) ::lve::LveProfiler::setThreadName(name)
+#else
+#define LVE_PROFILE_ZONE(name) do { (void)sizeof(name); } while(0)
+#define LVE_PROFILE_FUNCTION() do {} while(0)
+#define LVE_PROFILE_THREAD(name) do { (void)sizeof(name); } while(0)
+#endif
@@ -3,6 +3,7 @@
 #include "lve_game_object.hpp"
 #include "lve_model.hpp"
 #include "lve_pipeline.hpp"
+#include "lve_profiler.hpp"
 #include "lve_swap_chain.hpp"
 #include "lve_window.hpp"
 #include <GLFW/glfw3.h>
@@ -15,6 +16,7 @@
 #include <glm/common.hpp>
 #include <glm/fwd.hpp>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <vector>
 #include <vulkan/vulkan_core.h>
@@ -22,9 +24,24 @@
 
 namespace lve {
 
-LveRenderer::LveRenderer(LveWindow& window, LveDevice& device) : lveWindow(window), lveDevice(device){
+LveRenderer::LveRenderer(LveWindow& window, LveDevice& device, LveJobSystem *jobSystem) : lveWindow(&window), lveDevice(device){
 	recreateSwapChain();
+	init(jobSystem);
+}
+
+LveRenderer::LveRenderer(LveDevice& device, VkExtent2D extent, LveJobSystem *jobSystem) : lveWindow(nullptr), lveDevice(device){
+	offscreenTarget = std::make_unique<LveOffscreenTarget>(lveDevice, extent);
+	init(jobSystem);
+}
+
+void LveRenderer::init(LveJobSystem *jobSystem){
 	createCommandBuffers();
+	if(jobSystem != nullptr && jobSystem->getThreadCount() > 1){
+		parallelRecorder = std::make_unique<LveParallelRecorder>(lveDevice, *jobSystem);
+	}
+	if(LveGpuProfiler::isSupported(lveDevice)){
+		gpuProfiler = std::make_unique<LveGpuProfiler>(lveDevice, LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+	}
 }
 
 LveRenderer::~LveRenderer(){
@@ -50,14 +67,18 @@ void LveRenderer::createCommandBuffers(){
 }
 
 void LveRenderer::recreateSwapChain(){
-	auto extent = lveWindow.getExtent();
+	LVE_PROFILE_ZONE("recreate swap chain");
+	auto extent = lveWindow->getExtent();
 	// stall if minimized
 	while (extent.width == 0 || extent.height == 0) {
-		extent = lveWindow.getExtent();
-		glfwWaitEvents();
+		extent = lveWindow->getExtent();
+		lveWindow->waitEvents();
 	}
 	// wait till current swap chain stops being used
-	vkDeviceWaitIdle(lveDevice.device());
+	{
+		std::lock_guard<std::mutex> lock(lveDevice.queueMutex());
+		vkDeviceWaitIdle(lveDevice.device());
+	}
 
 	if(lveSwapChain == nullptr){
 		lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent);
@@ -81,8 +102,9 @@ void LveRenderer::freeCommandBuffers(){
 
 VkCommandBuffer LveRenderer::beginFrame(){
 	assert(!isFrameStarted && "Can't call begin when frame already in progress");
+	LVE_PROFILE_ZONE("begin frame");
 
-	auto result = lveSwapChain->acquireNextImage(&currentImageIndex);
+	auto result = offscreenTarget ? offscreenTarget->acquireNextImage(&currentImageIndex) : lveSwapChain->acquireNextImage(&currentImageIndex);
 
 	if(result == VK_ERROR_OUT_OF_DATE_KHR){
 		recreateSwapChain();
@@ -104,25 +126,40 @@ VkCommandBuffer LveRenderer::beginFrame(){
 	if(vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS){
 		throw std::runtime_error("Failed to begin command buffer");
 	}
+	// the fence of this frame index was waited on while acquiring, its old queries are done
+	if(gpuProfiler){
+		gpuProfiler->beginFrame(commandBuffer, currentFrameIndex);
+	}
 
 	return commandBuffer;
 }
 
 void LveRenderer::endFrame(){
 	assert(isFrameStarted && "Can't end a frame with no frames in progress");
+	LVE_PROFILE_ZONE("end frame");
 
 	auto commandBuffer = getCurrentCommandBuffer();
+	if(gpuProfiler){
+		gpuProfiler->endFrame(commandBuffer);
+	}
 	if(vkEndCommandBuffer(commandBuffer) !=VK_SUCCESS){
 		throw std::runtime_error("Failed to record command buffer!");
 	}
 
-	auto result = lveSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
-	if(result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || lveWindow.wasWindowResized()){
-		lveWindow.resetWindowResizedFlag();
-		recreateSwapChain();
+	// an offscreen target never goes out of date, there is no window to resize
+	if(offscreenTarget){
+		offscreenTarget->submitCommandBuffers(&commandBuffer, &currentImageIndex);
 	}
-	else if(result != VK_SUCCESS){
-		throw std::runtime_error("Failed to present swap chain image!");
+	else{
+		auto result = lveSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+		// consumed even when the swap chain is recreated anyway, so a resize isn't handled twice
+		bool resized = lveWindow->consumeWindowResizedFlag();
+		if(result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || resized){
+			recreateSwapChain();
+		}
+		else if(result != VK_SUCCESS){
+			throw std::runtime_error("Failed to present swap chain image!");
+		}
 	}
 
 	isFrameStarted = false;
@@ -143,23 +180,35 @@ void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer){
 
 	VkRenderPassBeginInfo renderPassInfo{
 		.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-		.renderPass = lveSwapChain->getRenderPass(),
-		.framebuffer = lveSwapChain->getFrameBuffer(currentImageIndex),
+		.renderPass = getSwapChainRenderPass(),
+		.framebuffer = offscreenTarget ? offscreenTarget->getFrameBuffer(currentImageIndex) : lveSwapChain->getFrameBuffer(currentImageIndex),
 		.renderArea {
 			.offset = {0,0},
-			.extent = lveSwapChain->getSwapChainExtent()
+			.extent = getExtent()
 		},
 		.clearValueCount = static_cast<uint32_t>(clearValues.size()),
 		.pClearValues = clearValues.data()
 	};
 
+	if(gpuProfiler){
+		renderPassScope = gpuProfiler->beginScope("render pass");
+		gpuProfiler->writeBeginTimestamp(commandBuffer, renderPassScope);
+	}
+
+	if(parallelRecorder){
+		// only vkCmdExecuteCommands is allowed in the primary now, the recorder sets viewport and scissor
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		parallelRecorder->beginFrame(currentFrameIndex, renderPassInfo.renderPass, renderPassInfo.framebuffer, renderPassInfo.renderArea.extent);
+		return;
+	}
+
 	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
 	VkViewport viewPort{
 		.x = 0.0f,
 		.y = 0.0f,
-		.width = static_cast<float>(lveSwapChain->getSwapChainExtent().width),
-		.height = static_cast<float>(lveSwapChain->getSwapChainExtent().height),
+		.width = static_cast<float>(getExtent().width),
+		.height = static_cast<float>(getExtent().height),
 		.minDepth = 0.0f,
 		.maxDepth = 1.0f
 	};
@@ -168,7 +217,7 @@ void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer){
 			.x = 0,
 			.y = 0
 		},
-		.extent = lveSwapChain->getSwapChainExtent()
+		.extent = getExtent()
 	};
 	vkCmdSetViewport(commandBuffer,0, 1, &viewPort);
 	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
@@ -179,6 +228,10 @@ void LveRenderer::endSwapChainRenderPass(VkCommandBuffer commandBuffer){
 	assert(commandBuffer == getCurrentCommandBuffer() && "Can't end a render pass on a command buffer from a different frame");
 
 	vkCmdEndRenderPass(commandBuffer);
+	if(gpuProfiler){
+		gpuProfiler->writeEndTimestamp(commandBuffer, renderPassScope);
+		gpuProfiler->endScope();
+	}
 }
 
 
@@ -9,23 +9,37 @@
 #include "lve_window.hpp"
 #include "lve_device.hpp"
 #include "lve_swap_chain.hpp"
+#include "lve_offscreen_target.hpp"
+#include "lve_gpu_profiler.hpp"
+#include "lve_job_system.hpp"
+#include "lve_parallel_recorder.hpp"
 
 namespace lve {
 class LveRenderer{
 public:
-	LveRenderer(LveWindow& lveWindow, LveDevice& lveDevice);
+	// with a multi threaded job system the render pass contents come from secondary command buffers recorded as jobs
+	LveRenderer(LveWindow& lveWindow, LveDevice& lveDevice, LveJobSystem *jobSystem = nullptr);
+	// headless, frames go into an offscreen target of a fixed size instead of a swap chain
+	LveRenderer(LveDevice& lveDevice, VkExtent2D extent, LveJobSystem *jobSystem = nullptr);
 	~LveRenderer();
 
 	// deleting copy constructors for memory safety
 	LveRenderer(const LveRenderer&) = delete;
 	LveRenderer operator=(const LveRenderer&) = delete;
 
-	VkRenderPass getSwapChainRenderPass() const { return lveSwapChain->getRenderPass(); };
+	// the offscreen pass when headless, pipelines don't need to know the difference
+	VkRenderPass getSwapChainRenderPass() const { return offscreenTarget ? offscreenTarget->getRenderPass() : lveSwapChain->getRenderPass(); };
+	// nullptr unless headless
+	LveOffscreenTarget *getOffscreenTarget() const { return offscreenTarget.get(); }
 	bool isFrameInProgress() const { return isFrameStarted; };
 	VkCommandBuffer getCurrentCommandBuffer() const { 
 		assert(isFrameStarted && "Cannot get command buffer when frame not in progress");
 		return commandBuffers[currentFrameIndex]; 
 	};
+	// nullptr when recording inline on the calling thread
+	LveParallelRecorder *getParallelRecorder() const { return parallelRecorder.get(); }
+	// nullptr when the device can't write timestamps, the frame and render pass are always profiled
+	LveGpuProfiler *getGpuProfiler() const { return gpuProfiler.get(); }
 	int getFrameIndex() const {
 		assert(isFrameStarted && "Cannot get frame index when frame not in progress");
 		return currentFrameIndex;
@@ -38,17 +52,24 @@ public:
 	void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
 private:
-	// our window object created on instance
-	LveWindow& lveWindow;
+	// our window object created on instance, nullptr when headless
+	LveWindow* lveWindow;
 	LveDevice& lveDevice;
+	// exactly one of the two exists
 	std::unique_ptr<LveSwapChain> lveSwapChain;
+	std::unique_ptr<LveOffscreenTarget> offscreenTarget;
 	std::vector<VkCommandBuffer> commandBuffers;
+	std::unique_ptr<LveParallelRecorder> parallelRecorder;
+	std::unique_ptr<LveGpuProfiler> gpuProfiler;
+	uint32_t renderPassScope = LveGpuProfiler::INVALID_SCOPE;
 	uint32_t currentImageIndex;
 	int currentFrameIndex = 0;
 	bool isFrameStarted = false;
 
+	void init(LveJobSystem *jobSystem);
 	void createCommandBuffers();
 	void freeCommandBuffers();
 	void recreateSwapChain();
+	VkExtent2D getExtent() const { return offscreenTarget ? offscreenTarget->getExtent() : lveSwapChain->getSwapChainExtent(); }
 };
 }
\ No newline at end of file
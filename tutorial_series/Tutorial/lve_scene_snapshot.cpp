@@ -0,0 +1,123 @@
+#include "lve_scene_snapshot.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+void LveSceneSnapshot::copySlot(const LveGameObjectStore &store, uint32_t slot){
+	translationData[slot] = store.translations()[slot];
+	scaleData[slot] = store.scales()[slot];
+	rotationData[slot] = store.rotations()[slot];
+	colorData[slot] = store.colors()[slot];
+	modelData[slot] = store.models()[slot];
+	previousTranslationData[slot] = store.previousTranslations()[slot];
+	previousScaleData[slot] = store.previousScales()[slot];
+	previousRotationData[slot] = store.previousRotations()[slot];
+}
+
+void LveSceneSnapshot::copyAll(const LveGameObjectStore &store){
+	uint32_t count = store.size();
+	translationData.assign(store.translations(), store.translations() + count);
+	scaleData.assign(store.scales(), store.scales() + count);
+	rotationData.assign(store.rotations(), store.rotations() + count);
+	colorData.assign(store.colors(), store.colors() + count);
+	modelData.assign(store.models(), store.models() + count);
+	previousTranslationData.assign(store.previousTranslations(), store.previousTranslations() + count);
+	previousScaleData.assign(store.previousScales(), store.previousScales() + count);
+	previousRotationData.assign(store.previousRotations(), store.previousRotations() + count);
+}
+
+void LveSceneBuffer::publish(LveGameObjectStore &store, std::chrono::steady_clock::time_point stepTime){
+	sequence++;
+	if(store.getLayoutVersion() != layoutVersion){
+		// slots moved around, nothing logged so far applies any more
+		log.clear();
+		loggedSlots = 0;
+		logStart = sequence;
+		layoutVersion = store.getLayoutVersion();
+	}
+	else if(!store.getChangedSlots().empty()){
+		log.push_back({sequence, store.getChangedSlots()});
+		loggedSlots += store.getChangedSlots().size();
+	}
+	store.clearChanges();
+
+	// a stalled consumer would let the log grow forever, past a few full copies worth it is cheaper to start over
+	while(loggedSlots > 4 * std::max(store.size(), 1024u)){
+		loggedSlots -= log.front().slots.size();
+		logStart = log.front().sequence;
+		log.pop_front();
+	}
+
+	auto &snapshot = snapshots.getBackBuffer();
+	if(snapshot.layoutVersion != layoutVersion || snapshot.sequence < logStart){
+		snapshot.copyAll(store);
+	}
+	else{
+		for(auto &entry : log){
+			if(entry.sequence > snapshot.sequence){
+				for(uint32_t slot : entry.slots){
+					snapshot.copySlot(store, slot);
+				}
+			}
+		}
+	}
+	snapshot.sequence = sequence;
+	snapshot.layoutVersion = layoutVersion;
+	snapshot.stepTime = stepTime;
+	snapshot.movingSlots = store.getMovingSlots();
+
+	// changes since whatever the consumer has seen, if that is still covered by the log
+	uint64_t consumed = consumedSequence.load(std::memory_order_acquire);
+	snapshot.changedSlots.clear();
+	if(consumed == 0 || consumed < logStart){
+		snapshot.baseSequence = sequence;
+	}
+	else{
+		snapshot.baseSequence = consumed;
+		slotFlags.resize(store.size(), 0);
+		for(uint32_t slot : snapshot.movingSlots){
+			slotFlags[slot] = 1;
+		}
+		for(auto &entry : log){
+			if(entry.sequence <= consumed){
+				continue;
+			}
+			for(uint32_t slot : entry.slots){
+				if(!slotFlags[slot]){
+					slotFlags[slot] = 1;
+					snapshot.changedSlots.push_back(slot);
+				}
+			}
+		}
+		for(uint32_t slot : snapshot.movingSlots){
+			slotFlags[slot] = 0;
+		}
+		for(uint32_t slot : snapshot.changedSlots){
+			slotFlags[slot] = 0;
+		}
+	}
+	snapshots.publish();
+
+	// entries every buffer and the consumer are past won't be needed again
+	uint64_t oldest = consumed;
+	for(uint32_t i = 0; i < 3; i++){
+		oldest = std::min(oldest, snapshots.getBuffer(i).sequence);
+	}
+	while(!log.empty() && log.front().sequence <= oldest){
+		loggedSlots -= log.front().slots.size();
+		log.pop_front();
+	}
+}
+
+bool LveSceneBuffer::acquire(){
+	if(!snapshots.acquire()){
+		return false;
+	}
+	consumedSequence.store(snapshots.getFrontBuffer().sequence, std::memory_order_release);
+	return true;
+}
+
+}
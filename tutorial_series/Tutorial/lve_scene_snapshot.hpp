@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <glm/fwd.hpp>
+
+#include "lve_game_object.hpp"
+#include "lve_model.hpp"
+#include "lve_triple_buffer.hpp"
+
+namespace lve {
+
+// what rendering needs from a LveGameObjectStore at one point of the simulation, never changes
+// once published so the render thread can read it while the simulation carries on
+class LveSceneSnapshot {
+public:
+	uint32_t size() const {return static_cast<uint32_t>(translationData.size());}
+	bool empty() const {return translationData.empty();}
+
+	// same layout as the store's component arrays
+	const glm::vec2 *translations() const {return translationData.data();}
+	const glm::vec2 *scales() const {return scaleData.data();}
+	const float *rotations() const {return rotationData.data();}
+	const glm::vec3 *colors() const {return colorData.data();}
+	const std::shared_ptr<LveModel> *models() const {return modelData.data();}
+	const glm::vec2 *previousTranslations() const {return previousTranslationData.data();}
+	const glm::vec2 *previousScales() const {return previousScaleData.data();}
+	const float *previousRotations() const {return previousRotationData.data();}
+
+	// increases with every publish
+	uint64_t getSequence() const {return sequence;}
+	// changed slots are relative to this snapshot, a consumer that saw anything older has to start over
+	uint64_t getBaseSequence() const {return baseSequence;}
+	uint32_t getLayoutVersion() const {return layoutVersion;}
+	// slots edited since the base snapshot, moving ones are left out
+	const std::vector<uint32_t> &getChangedSlots() const {return changedSlots;}
+	// slots whose rendered transform depends on the interpolation factor
+	const std::vector<uint32_t> &getMovingSlots() const {return movingSlots;}
+	// real time the current state belongs to, the previous state is one fixed step before it
+	std::chrono::steady_clock::time_point getStepTime() const {return stepTime;}
+
+private:
+	friend class LveSceneBuffer;
+
+	std::vector<glm::vec2> translationData;
+	std::vector<glm::vec2> scaleData;
+	std::vector<float> rotationData;
+	std::vector<glm::vec3> colorData;
+	std::vector<std::shared_ptr<LveModel>> modelData;
+	std::vector<glm::vec2> previousTranslationData;
+	std::vector<glm::vec2> previousScaleData;
+	std::vector<float> previousRotationData;
+
+	uint64_t sequence = 0;
+	uint64_t baseSequence = 0;
+	uint32_t layoutVersion = UINT32_MAX;
+	std::vector<uint32_t> changedSlots;
+	std::vector<uint32_t> movingSlots;
+	std::chrono::steady_clock::time_point stepTime{};
+
+	void copySlot(const LveGameObjectStore &store, uint32_t slot);
+	void copyAll(const LveGameObjectStore &store);
+};
+
+// hands snapshots of a store from the simulation thread to the render thread through a triple buffer.
+// Snapshots are written incrementally: every publish logs the store's change list, the buffer being
+// written only copies the slots changed since it was last written, and the change list a snapshot
+// carries covers everything since the snapshot the consumer last acquired, so dropped snapshots
+// don't lose edits. Works the same with both sides on one thread.
+class LveSceneBuffer {
+public:
+	LveSceneBuffer() = default;
+
+	// deleting copy constructors, both threads hold references into it
+	LveSceneBuffer(const LveSceneBuffer&) = delete;
+	LveSceneBuffer operator=(const LveSceneBuffer&) = delete;
+
+	// producer side, consumes the store's change list
+	void publish(LveGameObjectStore &store, std::chrono::steady_clock::time_point stepTime);
+
+	// consumer side, switches to the latest snapshot, false if nothing new was published
+	bool acquire();
+	const LveSceneSnapshot &getSnapshot() const {return snapshots.getFrontBuffer();}
+
+private:
+	struct LogEntry {
+		uint64_t sequence;
+		std::vector<uint32_t> slots;
+	};
+
+	LveTripleBuffer<LveSceneSnapshot> snapshots;
+	std::atomic<uint64_t> consumedSequence{0};
+
+	// producer only
+	uint64_t sequence = 0;
+	uint32_t layoutVersion = UINT32_MAX;
+	uint64_t logStart = 0;			// changes before this sequence are no longer logged
+	std::deque<LogEntry> log;
+	size_t loggedSlots = 0;
+	std::vector<uint8_t> slotFlags;	// scratch for deduplicating slots
+};
+
+}
@@ -0,0 +1,141 @@
+#include "lve_sierpinski.hpp"
+#include "lve_job_system.hpp"
+#include "lve_model.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+namespace {
+
+// below this many output triangles handing subtrees to the workers costs more than it saves
+constexpr size_t PARALLEL_MIN_TRIANGLES = 1 << 14;
+// subtrees per thread, enough for work stealing to even out uneven workers
+constexpr uint32_t SUBTREES_PER_THREAD = 8;
+
+LveModel::Vertex getMidpoint(const LveModel::Vertex &a, const LveModel::Vertex &b){
+	return {
+		{
+			(a.position.x + b.position.x)/2,
+			(a.position.y + b.position.y)/2
+		},
+		{
+			(a.color.r+b.color.r)/2,
+			(a.color.g+b.color.g)/2,
+			(a.color.b+b.color.b)/2
+		}
+	};
+}
+
+// replaces (a, b, c) by one of its corner triangles, in the order a single step emits them
+void selectCorner(LveModel::Vertex &a, LveModel::Vertex &b, LveModel::Vertex &c, uint32_t corner){
+	LveModel::Vertex ab = getMidpoint(a, b);
+	LveModel::Vertex bc = getMidpoint(b, c);
+	LveModel::Vertex ca = getMidpoint(c, a);
+	switch(corner){
+		case 0: b = ab; c = ca; break;
+		case 1: a = ca; b = bc; break;
+		default: a = ab; c = bc; break;
+	}
+}
+
+// depth first, so the corners of a triangle land next to each other exactly where `depth` single steps put them
+LveModel::Vertex *subdivide(const LveModel::Vertex &a, const LveModel::Vertex &b, const LveModel::Vertex &c, uint32_t depth, LveModel::Vertex *out){
+	if(depth == 0){
+		out[0] = a;
+		out[1] = b;
+		out[2] = c;
+		return out + 3;
+	}
+	LveModel::Vertex ab = getMidpoint(a, b);
+	LveModel::Vertex bc = getMidpoint(b, c);
+	LveModel::Vertex ca = getMidpoint(c, a);
+	out = subdivide(a, ab, ca, depth - 1, out);
+	out = subdivide(ca, bc, c, depth - 1, out);
+	return subdivide(ab, b, bc, depth - 1, out);
+}
+
+size_t powerOfThree(uint32_t exponent){
+	size_t result = 1;
+	for(uint32_t i = 0; i < exponent; i++){
+		result *= 3;
+	}
+	return result;
+}
+
+}
+
+size_t getSierpinskiVertexCount(size_t vertexCount, uint32_t depth){
+	return vertexCount / 3 * 3 * powerOfThree(depth);
+}
+
+void generateSierpinski(const LveModel::Vertex *original, size_t vertexCount, uint32_t depth, LveModel::Vertex *out, LveJobSystem *jobSystem){
+	size_t triangleCount = vertexCount / 3;
+	size_t outputTriangles = triangleCount * powerOfThree(depth);
+
+	if(jobSystem == nullptr || jobSystem->getThreadCount() < 2 || outputTriangles < PARALLEL_MIN_TRIANGLES){
+		for(size_t i = 0; i < triangleCount; i++){
+			out = subdivide(original[i*3], original[i*3+1], original[i*3+2], depth, out);
+		}
+		return;
+	}
+
+	// the first splitLevels steps only pick subtree roots, every job generates whole subtrees from there
+	uint32_t splitLevels = 0;
+	size_t subtreeCount = triangleCount;
+	while(splitLevels < depth && subtreeCount < size_t(jobSystem->getThreadCount()) * SUBTREES_PER_THREAD){
+		splitLevels++;
+		subtreeCount *= 3;
+	}
+	uint32_t subtreeDepth = depth - splitLevels;
+	size_t subtreesPerTriangle = powerOfThree(splitLevels);
+	size_t verticesPerSubtree = 3 * powerOfThree(subtreeDepth);
+
+	jobSystem->parallelFor(static_cast<uint32_t>(subtreeCount), 1, [&](uint32_t begin, uint32_t end){
+		for(uint32_t subtree = begin; subtree < end; subtree++){
+			size_t triangle = subtree / subtreesPerTriangle;
+			LveModel::Vertex a = original[triangle*3];
+			LveModel::Vertex b = original[triangle*3+1];
+			LveModel::Vertex c = original[triangle*3+2];
+			// the base 3 digits of the subtree's index within its triangle, most significant first, are the corners to take
+			size_t path = subtree % subtreesPerTriangle;
+			for(size_t digit = subtreesPerTriangle / 3; digit > 0; digit /= 3){
+				selectCorner(a, b, c, static_cast<uint32_t>(path / digit % 3));
+			}
+			subdivide(a, b, c, subtreeDepth, out + subtree * verticesPerSubtree);
+		}
+	});
+}
+
+std::vector<LveModel::Vertex> generateSierpinski(const std::vector<LveModel::Vertex> &original, uint32_t depth, LveJobSystem *jobSystem){
+	// every step triples the mesh, check before the vertex count wraps around instead of writing past the buffer
+	size_t maxTriangles = std::vector<LveModel::Vertex>{}.max_size() / 3;
+	for(size_t i = 0, triangles = original.size() / 3; i < depth && triangles > 0; i++, triangles *= 3){
+		if(triangles > maxTriangles / 3){
+			throw std::runtime_error("Sierpinski mesh of depth " + std::to_string(depth) + " is too large");
+		}
+	}
+	std::vector<LveModel::Vertex> out(getSierpinskiVertexCount(original.size(), depth));
+	generateSierpinski(original.data(), original.size(), depth, out.data(), jobSystem);
+	return out;
+}
+
+void indexVertices(const std::vector<LveModel::Vertex> &input, std::vector<LveModel::Vertex> &vertices, std::vector<uint32_t> &indices){
+	std::map<std::array<float, 5>, uint32_t> unique;
+	indices.reserve(input.size());
+	for(auto &vertex : input){
+		std::array<float, 5> key = {vertex.position.x, vertex.position.y, vertex.color.r, vertex.color.g, vertex.color.b};
+		auto [it, inserted] = unique.try_emplace(key, static_cast<uint32_t>(vertices.size()));
+		if(inserted){
+			vertices.push_back(vertex);
+		}
+		indices.push_back(it->second);
+	}
+}
+
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "lve_job_system.hpp"
+#include "lve_model.hpp"
+
+namespace lve {
+
+// vertices of a triangle list after `depth` Sierpinski steps, every step triples them
+size_t getSierpinskiVertexCount(size_t vertexCount, uint32_t depth);
+
+// applies `depth` Sierpinski steps to the triangle list at once, every triangle becomes its three corner
+// triangles per step. Writes getSierpinskiVertexCount vertices to out, which can be a mapped buffer,
+// and allocates nothing. With a job system large meshes are split into subtrees generated in parallel.
+void generateSierpinski(const LveModel::Vertex *original, size_t vertexCount, uint32_t depth, LveModel::Vertex *out, LveJobSystem *jobSystem = nullptr);
+std::vector<LveModel::Vertex> generateSierpinski(const std::vector<LveModel::Vertex> &original, uint32_t depth = 1, LveJobSystem *jobSystem = nullptr);
+
+// shared corners are stored once and referenced by index
+void indexVertices(const std::vector<LveModel::Vertex> &input, std::vector<LveModel::Vertex> &vertices, std::vector<uint32_t> &indices);
+
+}
@@ -0,0 +1,267 @@
+#include "lve_sierpinski_compute.hpp"
+#include "lve_device.hpp"
+#include "lve_model.hpp"
+#include "lve_pipeline.hpp"
+#include "lve_profiler.hpp"
+#include "lve_sierpinski.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace lve {
+
+namespace {
+
+// must match local_size_x in sierpinski.comp
+constexpr uint32_t WORKGROUP_SIZE = 64;
+// 3^20 subtrees per triangle still fit the shader's 32 bit indices, buffers run out long before
+constexpr uint32_t MAX_DEPTH = 20;
+
+struct SierpinskiPush {
+	uint32_t subtreesPerTriangle;
+	uint32_t outputTriangles;
+};
+
+static_assert(sizeof(LveModel::Vertex) == 5 * sizeof(float), "the shader reads and writes vertices as 5 packed floats");
+
+}
+
+LveSierpinskiCompute::LveSierpinskiCompute(LveDevice &device, const std::string &shaderPath) : lveDevice(device){
+	createDescriptorSet();
+	createPipeline(shaderPath);
+}
+
+LveSierpinskiCompute::~LveSierpinskiCompute(){
+	vkDestroyPipeline(lveDevice.device(), pipeline, nullptr);
+	vkDestroyShaderModule(lveDevice.device(), shaderModule, nullptr);
+	vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+	// frees the set with it
+	vkDestroyDescriptorPool(lveDevice.device(), descriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(lveDevice.device(), descriptorSetLayout, nullptr);
+}
+
+void LveSierpinskiCompute::createDescriptorSet(){
+	// input triangles, then the generated vertices
+	VkDescriptorSetLayoutBinding bindings[2] = {
+		{
+			.binding = 0,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		},
+		{
+			.binding = 1,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		}
+	};
+	VkDescriptorSetLayoutCreateInfo layoutInfo{
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+		.bindingCount = 2,
+		.pBindings = bindings,
+	};
+	if(vkCreateDescriptorSetLayout(lveDevice.device(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS){
+		throw std::runtime_error("Failed to create descriptor set layout");
+	}
+
+	VkDescriptorPoolSize poolSize{
+		.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		.descriptorCount = 2,
+	};
+	VkDescriptorPoolCreateInfo poolInfo{
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+		.maxSets = 1,
+		.poolSizeCount = 1,
+		.pPoolSizes = &poolSize,
+	};
+	if(vkCreateDescriptorPool(lveDevice.device(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS){
+		throw std::runtime_error("Failed to create descriptor pool");
+	}
+
+	VkDescriptorSetAllocateInfo allocInfo{
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+		.descriptorPool = descriptorPool,
+		.descriptorSetCount = 1,
+		.pSetLayouts = &descriptorSetLayout,
+	};
+	if(vkAllocateDescriptorSets(lveDevice.device(), &allocInfo, &descriptorSet) != VK_SUCCESS){
+		throw std::runtime_error("Failed to allocate descriptor set");
+	}
+}
+
+void LveSierpinskiCompute::createPipeline(const std::string &shaderPath){
+	VkPushConstantRange pushConstantRange{
+		.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+		.offset = 0,
+		.size = sizeof(SierpinskiPush),
+	};
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+		.setLayoutCount = 1,
+		.pSetLayouts = &descriptorSetLayout,
+		.pushConstantRangeCount = 1,
+		.pPushConstantRanges = &pushConstantRange,
+	};
+	if(vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS){
+		throw std::runtime_error("Failed to create pipeline layout");
+	}
+
+	auto code = LvePipeline::readFile(shaderPath);
+	VkShaderModuleCreateInfo moduleInfo{
+		.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+		.codeSize = code.size(),
+		.pCode = reinterpret_cast<const uint32_t*>(code.data())
+	};
+	if(vkCreateShaderModule(lveDevice.device(), &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS){
+		throw std::runtime_error("Failed to create shader module");
+	}
+
+	VkComputePipelineCreateInfo pipelineInfo{
+		.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+		.stage = {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+			.stage = VK_SHADER_STAGE_COMPUTE_BIT,
+			.module = shaderModule,
+			.pName = "main",
+		},
+		.layout = pipelineLayout,
+	};
+	if(vkCreateComputePipelines(lveDevice.device(), lveDevice.pipelineCache(), 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS){
+		throw std::runtime_error("Failed to create compute pipeline");
+	}
+}
+
+void LveSierpinskiCompute::dispatch(const std::vector<LveModel::Vertex> &original, uint32_t depth, VkBufferUsageFlags usage, VkBuffer &buffer, LveAllocation &memory, uint32_t &vertexCount){
+	if(original.size() < 3){
+		throw std::runtime_error("Sierpinski generation needs at least one triangle");
+	}
+	size_t outputVertices = depth <= MAX_DEPTH ? getSierpinskiVertexCount(original.size(), depth) : SIZE_MAX;
+	VkDeviceSize outputSize = outputVertices * sizeof(LveModel::Vertex);
+	if(outputVertices > UINT32_MAX || outputSize > lveDevice.properties.limits.maxStorageBufferRange){
+		throw std::runtime_error("Sierpinski mesh of depth " + std::to_string(depth) + " doesn't fit in one storage buffer");
+	}
+
+	// only the input triangles are uploaded, a few bytes however deep the mesh gets
+	VkDeviceSize inputSize = original.size() / 3 * 3 * sizeof(LveModel::Vertex);
+	VkBuffer inputBuffer;
+	LveAllocation inputMemory;
+	lveDevice.createBuffer(
+		inputSize,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		inputBuffer,
+		inputMemory
+	);
+	memcpy(inputMemory.mapped, original.data(), static_cast<size_t>(inputSize));
+
+	lveDevice.createBuffer(outputSize, usage | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, memory);
+	vertexCount = static_cast<uint32_t>(outputVertices);
+
+	VkDescriptorBufferInfo bufferInfos[2] = {
+		{.buffer = inputBuffer, .offset = 0, .range = inputSize},
+		{.buffer = buffer, .offset = 0, .range = outputSize},
+	};
+	VkWriteDescriptorSet writes[2];
+	for(uint32_t i = 0; i < 2; i++){
+		writes[i] = {
+			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			.dstSet = descriptorSet,
+			.dstBinding = i,
+			.descriptorCount = 1,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.pBufferInfo = &bufferInfos[i],
+		};
+	}
+	vkUpdateDescriptorSets(lveDevice.device(), 2, writes, 0, nullptr);
+
+	SierpinskiPush push{
+		.subtreesPerTriangle = static_cast<uint32_t>(outputVertices / (original.size() / 3 * 3)),
+		.outputTriangles = vertexCount / 3,
+	};
+	// invocations loop when there are more triangles than the dispatch limit allows work groups
+	uint32_t groupCount = std::min((push.outputTriangles + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, lveDevice.properties.limits.maxComputeWorkGroupCount[0]);
+
+	VkCommandBuffer commandBuffer = lveDevice.beginSingleTimeCommands();
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(SierpinskiPush), &push);
+	vkCmdDispatch(commandBuffer, groupCount, 1, 1);
+
+	// later submits on the queue draw from the buffer or copy it out
+	VkMemoryBarrier barrier{
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT,
+	};
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+	lveDevice.endSingleTimeCommands(commandBuffer);
+
+	vkDestroyBuffer(lveDevice.device(), inputBuffer, nullptr);
+	lveDevice.freeMemory(inputMemory);
+}
+
+std::unique_ptr<LveModel> LveSierpinskiCompute::generate(const std::vector<LveModel::Vertex> &original, uint32_t depth){
+	LVE_PROFILE_ZONE("generate sierpinski");
+	VkBuffer buffer;
+	LveAllocation memory;
+	uint32_t vertexCount;
+	dispatch(original, depth, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, buffer, memory, vertexCount);
+	return std::make_unique<LveModel>(lveDevice, buffer, memory, vertexCount);
+}
+
+float LveSierpinskiCompute::validate(const std::vector<LveModel::Vertex> &original, uint32_t depth){
+	VkBuffer buffer;
+	LveAllocation memory;
+	uint32_t vertexCount;
+	dispatch(original, depth, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, buffer, memory, vertexCount);
+
+	VkDeviceSize size = vertexCount * sizeof(LveModel::Vertex);
+	VkBuffer readbackBuffer;
+	LveAllocation readbackMemory;
+	lveDevice.createBuffer(
+		size,
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		readbackBuffer,
+		readbackMemory
+	);
+	VkCommandBuffer commandBuffer = lveDevice.beginSingleTimeCommands();
+	VkBufferCopy copyRegion{.srcOffset = 0, .dstOffset = 0, .size = size};
+	vkCmdCopyBuffer(commandBuffer, buffer, readbackBuffer, 1, &copyRegion);
+	VkMemoryBarrier barrier{
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+	};
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	lveDevice.endSingleTimeCommands(commandBuffer);
+
+	auto reference = generateSierpinski(original, depth);
+	std::vector<LveModel::Vertex> generated(vertexCount);
+	memcpy(generated.data(), readbackMemory.mapped, static_cast<size_t>(size));
+	float maxError = 0.0f;
+	for(size_t i = 0; i < generated.size(); i++){
+		for(int k = 0; k < 2; k++){
+			maxError = std::max(maxError, std::abs(generated[i].position[k] - reference[i].position[k]));
+		}
+		for(int k = 0; k < 3; k++){
+			maxError = std::max(maxError, std::abs(generated[i].color[k] - reference[i].color[k]));
+		}
+	}
+
+	vkDestroyBuffer(lveDevice.device(), readbackBuffer, nullptr);
+	lveDevice.freeMemory(readbackMemory);
+	vkDestroyBuffer(lveDevice.device(), buffer, nullptr);
+	lveDevice.freeMemory(memory);
+	return maxError;
+}
+
+}
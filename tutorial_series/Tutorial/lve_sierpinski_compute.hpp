@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "lve_device.hpp"
+#include "lve_model.hpp"
+
+namespace lve {
+
+// generates Sierpinski meshes with a compute shader straight into a device local vertex buffer, the vertices
+// never exist on the CPU or cross the bus. generateSierpinski in lve_sierpinski.hpp is the reference it
+// produces the same triangles as, validate compares the two.
+class LveSierpinskiCompute {
+public:
+	static constexpr const char *SHADER_PATH = "shaders/sierpinski.comp.spv";
+
+	LveSierpinskiCompute(LveDevice &device, const std::string &shaderPath = SHADER_PATH);
+	~LveSierpinskiCompute();
+
+	// deleting copy constructors to prevent vulkan object cloning
+	LveSierpinskiCompute(const LveSierpinskiCompute&) = delete;
+	LveSierpinskiCompute operator=(const LveSierpinskiCompute&) = delete;
+
+	// non indexed Float32 model of `depth` steps applied to the triangle list, blocks until the GPU is done
+	std::unique_ptr<LveModel> generate(const std::vector<LveModel::Vertex> &original, uint32_t depth);
+	// largest difference to the CPU reference over every vertex component, 0 when they match bit for bit
+	float validate(const std::vector<LveModel::Vertex> &original, uint32_t depth);
+
+private:
+	LveDevice &lveDevice;
+	VkDescriptorSetLayout descriptorSetLayout;
+	VkDescriptorPool descriptorPool;
+	// generating blocks, so one set rewritten per call is enough
+	VkDescriptorSet descriptorSet;
+	VkPipelineLayout pipelineLayout;
+	VkShaderModule shaderModule;
+	VkPipeline pipeline;
+
+	void createDescriptorSet();
+	void createPipeline(const std::string &shaderPath);
+	// creates `buffer` with `usage` and fills it on the GPU, it is ready for vertex input and transfers afterwards
+	void dispatch(const std::vector<LveModel::Vertex> &original, uint32_t depth, VkBufferUsageFlags usage, VkBuffer &buffer, LveAllocation &memory, uint32_t &vertexCount);
+};
+
+}
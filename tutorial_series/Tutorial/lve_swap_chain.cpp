@@ -1,4 +1,5 @@
 #include "lve_swap_chain.hpp"
+#include "lve_profiler.hpp"
 
 // std
 #include <array>
@@ -8,6 +9,7 @@
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <stdexcept>
 #include <vulkan/vulkan_core.h>
@@ -49,7 +51,7 @@ LveSwapChain::~LveSwapChain() {
   for (size_t i = 0; i < depthImages.size(); i++) {
     vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
     vkDestroyImage(device.device(), depthImages[i], nullptr);
-    vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+    device.freeMemory(depthImageMemorys[i]);
   }
 
   for (auto framebuffer : swapChainFramebuffers) {
@@ -67,13 +69,17 @@ LveSwapChain::~LveSwapChain() {
 }
 
 VkResult LveSwapChain::acquireNextImage(uint32_t *imageIndex) {
-  vkWaitForFences(
-      device.device(),
-      1,
-      &inFlightFences[currentFrame],
-      VK_TRUE,
-      std::numeric_limits<uint64_t>::max());
+  {
+    LVE_PROFILE_ZONE("wait for frame fence");
+    vkWaitForFences(
+        device.device(),
+        1,
+        &inFlightFences[currentFrame],
+        VK_TRUE,
+        std::numeric_limits<uint64_t>::max());
+  }
 
+  LVE_PROFILE_ZONE("acquire image");
   VkResult result = vkAcquireNextImageKHR(
       device.device(),
       swapChain,
@@ -88,6 +94,7 @@ VkResult LveSwapChain::acquireNextImage(uint32_t *imageIndex) {
 VkResult LveSwapChain::submitCommandBuffers(
     const VkCommandBuffer *buffers, uint32_t *imageIndex) {
   if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
+    LVE_PROFILE_ZONE("wait for image fence");
     vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
   }
   imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
@@ -109,9 +116,13 @@ VkResult LveSwapChain::submitCommandBuffers(
   submitInfo.pSignalSemaphores = signalSemaphores;
 
   vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
-  if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
-      VK_SUCCESS) {
-    throw std::runtime_error("failed to submit draw command buffer!");
+  std::lock_guard<std::mutex> lock(device.queueMutex());
+  {
+    LVE_PROFILE_ZONE("queue submit");
+    if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
+        VK_SUCCESS) {
+      throw std::runtime_error("failed to submit draw command buffer!");
+    }
   }
 
   VkPresentInfoKHR presentInfo = {};
@@ -126,6 +137,7 @@ VkResult LveSwapChain::submitCommandBuffers(
 
   presentInfo.pImageIndices = imageIndex;
 
+  LVE_PROFILE_ZONE("queue present");
   auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
 
   currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
@@ -0,0 +1,284 @@
+#include "lve_transform_batch.hpp"
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LVE_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace lve {
+
+namespace {
+	// x = k * pi/2 + r with |r| <= pi/4, pi/2 split in three so k * PIO2_1 and k * PIO2_2 are exact
+	constexpr float TWO_OVER_PI = 0.636619772367581343f;
+	constexpr float PIO2_1 = 1.5703125f;
+	constexpr float PIO2_2 = 4.837512969970703125e-4f;
+	constexpr float PIO2_3 = 7.54978995489188216e-8f;
+
+	// minimax polynomials on [-pi/4, pi/4], cephes sinf/cosf
+	constexpr float SIN_1 = -1.6666654611e-1f;
+	constexpr float SIN_2 = 8.3321608736e-3f;
+	constexpr float SIN_3 = -1.9515295891e-4f;
+	constexpr float COS_1 = 4.166664568298827e-2f;
+	constexpr float COS_2 = -1.388731625493765e-3f;
+	constexpr float COS_3 = 2.443315711809948e-5f;
+
+	void computeTransforms2dScalar(const float *scales, const float *rotations, uint32_t count, float *out){
+		for(uint32_t i = 0; i < count; i++){
+			float s, c;
+			fastSinCos(rotations[i], s, c);
+			float sx = scales[2 * i];
+			float sy = scales[2 * i + 1];
+			out[4 * i + 0] = c * sx;
+			out[4 * i + 1] = s * sx;
+			out[4 * i + 2] = -s * sy;
+			out[4 * i + 3] = c * sy;
+		}
+	}
+
+#ifdef LVE_X86_KERNELS
+	__attribute__((target("sse2")))
+	void computeTransforms2dSse2(const float *scales, const float *rotations, uint32_t count, float *out){
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128i two = _mm_set1_epi32(2);
+		const __m128 signBit = _mm_set1_ps(-0.0f);
+
+		uint32_t i = 0;
+		for(; i + 4 <= count; i += 4){
+			__m128 x = _mm_loadu_ps(rotations + i);
+			__m128i k = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(TWO_OVER_PI)));
+			__m128 kf = _mm_cvtepi32_ps(k);
+			__m128 r = _mm_sub_ps(x, _mm_mul_ps(kf, _mm_set1_ps(PIO2_1)));
+			r = _mm_sub_ps(r, _mm_mul_ps(kf, _mm_set1_ps(PIO2_2)));
+			r = _mm_sub_ps(r, _mm_mul_ps(kf, _mm_set1_ps(PIO2_3)));
+
+			__m128 z = _mm_mul_ps(r, r);
+			__m128 sp = _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(SIN_3)), _mm_set1_ps(SIN_2));
+			sp = _mm_add_ps(_mm_mul_ps(sp, z), _mm_set1_ps(SIN_1));
+			sp = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sp, z), r), r);
+			__m128 cp = _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(COS_3)), _mm_set1_ps(COS_2));
+			cp = _mm_add_ps(_mm_mul_ps(cp, z), _mm_set1_ps(COS_1));
+			cp = _mm_mul_ps(_mm_mul_ps(cp, z), z);
+			cp = _mm_add_ps(_mm_sub_ps(cp, _mm_mul_ps(z, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+
+			__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(k, one), one));
+			__m128 s = _mm_or_ps(_mm_and_ps(swap, cp), _mm_andnot_ps(swap, sp));
+			__m128 c = _mm_or_ps(_mm_and_ps(swap, sp), _mm_andnot_ps(swap, cp));
+			__m128 sinSign = _mm_and_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(k, two), two)), signBit);
+			__m128 cosSign = _mm_and_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_add_epi32(k, one), two), two)), signBit);
+			s = _mm_xor_ps(s, sinSign);
+			c = _mm_xor_ps(c, cosSign);
+
+			// deinterleave 4 xy pairs
+			__m128 a = _mm_loadu_ps(scales + 2 * i);
+			__m128 b = _mm_loadu_ps(scales + 2 * i + 4);
+			__m128 sx = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+			__m128 sy = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+
+			__m128 m0 = _mm_mul_ps(c, sx);
+			__m128 m1 = _mm_mul_ps(s, sx);
+			__m128 m2 = _mm_xor_ps(_mm_mul_ps(s, sy), signBit);
+			__m128 m3 = _mm_mul_ps(c, sy);
+			// rows are matrix elements, columns transforms, transpose to one matrix per register
+			_MM_TRANSPOSE4_PS(m0, m1, m2, m3);
+			_mm_storeu_ps(out + 4 * i, m0);
+			_mm_storeu_ps(out + 4 * i + 4, m1);
+			_mm_storeu_ps(out + 4 * i + 8, m2);
+			_mm_storeu_ps(out + 4 * i + 12, m3);
+		}
+		computeTransforms2dScalar(scales + 2 * i, rotations + i, count - i, out + 4 * i);
+	}
+
+	__attribute__((target("avx2,fma")))
+	void computeTransforms2dAvx2(const float *scales, const float *rotations, uint32_t count, float *out){
+		const __m256i one = _mm256_set1_epi32(1);
+		const __m256 signBit = _mm256_set1_ps(-0.0f);
+
+		uint32_t i = 0;
+		for(; i + 8 <= count; i += 8){
+			__m256 x = _mm256_loadu_ps(rotations + i);
+			__m256 kf = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(TWO_OVER_PI)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+			__m256i k = _mm256_cvtps_epi32(kf);
+			__m256 r = _mm256_fnmadd_ps(kf, _mm256_set1_ps(PIO2_1), x);
+			r = _mm256_fnmadd_ps(kf, _mm256_set1_ps(PIO2_2), r);
+			r = _mm256_fnmadd_ps(kf, _mm256_set1_ps(PIO2_3), r);
+
+			__m256 z = _mm256_mul_ps(r, r);
+			__m256 sp = _mm256_fmadd_ps(z, _mm256_set1_ps(SIN_3), _mm256_set1_ps(SIN_2));
+			sp = _mm256_fmadd_ps(sp, z, _mm256_set1_ps(SIN_1));
+			sp = _mm256_fmadd_ps(_mm256_mul_ps(sp, z), r, r);
+			__m256 cp = _mm256_fmadd_ps(z, _mm256_set1_ps(COS_3), _mm256_set1_ps(COS_2));
+			cp = _mm256_fmadd_ps(cp, z, _mm256_set1_ps(COS_1));
+			cp = _mm256_mul_ps(_mm256_mul_ps(cp, z), z);
+			cp = _mm256_add_ps(_mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), cp), _mm256_set1_ps(1.0f));
+
+			__m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(k, one), one));
+			__m256 s = _mm256_blendv_ps(sp, cp, swap);
+			__m256 c = _mm256_blendv_ps(cp, sp, swap);
+			// bit 1 of the quadrant shifted into the sign bit
+			__m256 sinSign = _mm256_and_ps(_mm256_castsi256_ps(_mm256_slli_epi32(k, 30)), signBit);
+			__m256 cosSign = _mm256_and_ps(_mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(k, one), 30)), signBit);
+			s = _mm256_xor_ps(s, sinSign);
+			c = _mm256_xor_ps(c, cosSign);
+
+			// deinterleave 8 xy pairs, the in lane shuffle leaves the 64 bit halves out of order
+			__m256 a = _mm256_loadu_ps(scales + 2 * i);
+			__m256 b = _mm256_loadu_ps(scales + 2 * i + 8);
+			__m256 sx = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+			__m256 sy = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+			sx = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sx), _MM_SHUFFLE(3, 1, 2, 0)));
+			sy = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sy), _MM_SHUFFLE(3, 1, 2, 0)));
+
+			__m256 m0 = _mm256_mul_ps(c, sx);
+			__m256 m1 = _mm256_mul_ps(s, sx);
+			__m256 m2 = _mm256_xor_ps(_mm256_mul_ps(s, sy), signBit);
+			__m256 m3 = _mm256_mul_ps(c, sy);
+
+			// 4x4 transposes within each 128 bit lane, then the lanes are put back in order
+			__m256 t0 = _mm256_unpacklo_ps(m0, m1);
+			__m256 t1 = _mm256_unpackhi_ps(m0, m1);
+			__m256 t2 = _mm256_unpacklo_ps(m2, m3);
+			__m256 t3 = _mm256_unpackhi_ps(m2, m3);
+			__m256 u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+			__m256 u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+			__m256 u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+			__m256 u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+			_mm256_storeu_ps(out + 4 * i, _mm256_permute2f128_ps(u0, u1, 0x20));
+			_mm256_storeu_ps(out + 4 * i + 8, _mm256_permute2f128_ps(u2, u3, 0x20));
+			_mm256_storeu_ps(out + 4 * i + 16, _mm256_permute2f128_ps(u0, u1, 0x31));
+			_mm256_storeu_ps(out + 4 * i + 24, _mm256_permute2f128_ps(u2, u3, 0x31));
+		}
+		computeTransforms2dScalar(scales + 2 * i, rotations + i, count - i, out + 4 * i);
+	}
+
+	// gcc flags the deliberately undefined pass through operands inside its own avx512 headers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+	__attribute__((target("avx512f")))
+	void computeTransforms2dAvx512(const float *scales, const float *rotations, uint32_t count, float *out){
+		const __m512i one = _mm512_set1_epi32(1);
+		const __m512i two = _mm512_set1_epi32(2);
+		const __m512i evenIndices = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+		const __m512i oddIndices = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+		const __m512i interleaveLow = _mm512_setr_epi32(0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+		const __m512i interleaveHigh = _mm512_setr_epi32(8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+		const __m512i pairsLow = _mm512_setr_epi64(0, 8, 1, 9, 2, 10, 3, 11);
+		const __m512i pairsHigh = _mm512_setr_epi64(4, 12, 5, 13, 6, 14, 7, 15);
+
+		uint32_t i = 0;
+		for(; i + 16 <= count; i += 16){
+			__m512 x = _mm512_loadu_ps(rotations + i);
+			__m512 kf = _mm512_roundscale_ps(_mm512_mul_ps(x, _mm512_set1_ps(TWO_OVER_PI)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+			__m512i k = _mm512_cvtps_epi32(kf);
+			__m512 r = _mm512_fnmadd_ps(kf, _mm512_set1_ps(PIO2_1), x);
+			r = _mm512_fnmadd_ps(kf, _mm512_set1_ps(PIO2_2), r);
+			r = _mm512_fnmadd_ps(kf, _mm512_set1_ps(PIO2_3), r);
+
+			__m512 z = _mm512_mul_ps(r, r);
+			__m512 sp = _mm512_fmadd_ps(z, _mm512_set1_ps(SIN_3), _mm512_set1_ps(SIN_2));
+			sp = _mm512_fmadd_ps(sp, z, _mm512_set1_ps(SIN_1));
+			sp = _mm512_fmadd_ps(_mm512_mul_ps(sp, z), r, r);
+			__m512 cp = _mm512_fmadd_ps(z, _mm512_set1_ps(COS_3), _mm512_set1_ps(COS_2));
+			cp = _mm512_fmadd_ps(cp, z, _mm512_set1_ps(COS_1));
+			cp = _mm512_mul_ps(_mm512_mul_ps(cp, z), z);
+			cp = _mm512_add_ps(_mm512_fnmadd_ps(z, _mm512_set1_ps(0.5f), cp), _mm512_set1_ps(1.0f));
+
+			__mmask16 swap = _mm512_test_epi32_mask(k, one);
+			__m512 s = _mm512_mask_blend_ps(swap, sp, cp);
+			__m512 c = _mm512_mask_blend_ps(swap, cp, sp);
+			s = _mm512_mask_sub_ps(s, _mm512_test_epi32_mask(k, two), _mm512_setzero_ps(), s);
+			c = _mm512_mask_sub_ps(c, _mm512_test_epi32_mask(_mm512_add_epi32(k, one), two), _mm512_setzero_ps(), c);
+
+			__m512 a = _mm512_loadu_ps(scales + 2 * i);
+			__m512 b = _mm512_loadu_ps(scales + 2 * i + 16);
+			__m512 sx = _mm512_permutex2var_ps(a, evenIndices, b);
+			__m512 sy = _mm512_permutex2var_ps(a, oddIndices, b);
+
+			__m512 m0 = _mm512_mul_ps(c, sx);
+			__m512 m1 = _mm512_mul_ps(s, sx);
+			__m512 m2 = _mm512_sub_ps(_mm512_setzero_ps(), _mm512_mul_ps(s, sy));
+			__m512 m3 = _mm512_mul_ps(c, sy);
+
+			// (m0, m1) and (m2, m3) interleaved to pairs, then the pairs interleaved to whole matrices
+			__m512d p01Low = _mm512_castps_pd(_mm512_permutex2var_ps(m0, interleaveLow, m1));
+			__m512d p01High = _mm512_castps_pd(_mm512_permutex2var_ps(m0, interleaveHigh, m1));
+			__m512d p23Low = _mm512_castps_pd(_mm512_permutex2var_ps(m2, interleaveLow, m3));
+			__m512d p23High = _mm512_castps_pd(_mm512_permutex2var_ps(m2, interleaveHigh, m3));
+			_mm512_storeu_pd(out + 4 * i, _mm512_permutex2var_pd(p01Low, pairsLow, p23Low));
+			_mm512_storeu_pd(out + 4 * i + 16, _mm512_permutex2var_pd(p01Low, pairsHigh, p23Low));
+			_mm512_storeu_pd(out + 4 * i + 32, _mm512_permutex2var_pd(p01High, pairsLow, p23High));
+			_mm512_storeu_pd(out + 4 * i + 48, _mm512_permutex2var_pd(p01High, pairsHigh, p23High));
+		}
+		computeTransforms2dScalar(scales + 2 * i, rotations + i, count - i, out + 4 * i);
+	}
+#pragma GCC diagnostic pop
+#endif
+}
+
+LveSimdLevel detectSimdLevel(){
+#ifdef LVE_X86_KERNELS
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx512f")){
+		return LveSimdLevel::Avx512;
+	}
+	if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")){
+		return LveSimdLevel::Avx2;
+	}
+	if(__builtin_cpu_supports("sse2")){
+		return LveSimdLevel::Sse2;
+	}
+#endif
+	return LveSimdLevel::Scalar;
+}
+
+const char *getSimdLevelName(LveSimdLevel level){
+	switch(level){
+		case LveSimdLevel::Sse2: return "sse2";
+		case LveSimdLevel::Avx2: return "avx2";
+		case LveSimdLevel::Avx512: return "avx512";
+		default: return "scalar";
+	}
+}
+
+void fastSinCos(float x, float &s, float &c){
+	float kf = std::nearbyint(x * TWO_OVER_PI);
+	int32_t k = static_cast<int32_t>(kf);
+	float r = x - kf * PIO2_1;
+	r -= kf * PIO2_2;
+	r -= kf * PIO2_3;
+
+	float z = r * r;
+	float sp = ((SIN_3 * z + SIN_2) * z + SIN_1) * z * r + r;
+	float cp = ((COS_3 * z + COS_2) * z + COS_1) * z * z - 0.5f * z + 1.0f;
+
+	// quadrant k: sin(r) and cos(r) swap on odd k, sin is negated for k & 2, cos for (k + 1) & 2
+	bool swap = k & 1;
+	s = swap ? cp : sp;
+	c = swap ? sp : cp;
+	if(k & 2){
+		s = -s;
+	}
+	if((k + 1) & 2){
+		c = -c;
+	}
+}
+
+void computeTransforms2d(const float *scales, const float *rotations, uint32_t count, float *out, LveSimdLevel level){
+	switch(level){
+#ifdef LVE_X86_KERNELS
+		case LveSimdLevel::Avx512: computeTransforms2dAvx512(scales, rotations, count, out); return;
+		case LveSimdLevel::Avx2: computeTransforms2dAvx2(scales, rotations, count, out); return;
+		case LveSimdLevel::Sse2: computeTransforms2dSse2(scales, rotations, count, out); return;
+#endif
+		default: computeTransforms2dScalar(scales, rotations, count, out); return;
+	}
+}
+
+void computeTransforms2d(const float *scales, const float *rotations, uint32_t count, float *out){
+	static const LveSimdLevel level = detectSimdLevel();
+	computeTransforms2d(scales, rotations, count, out, level);
+}
+
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+namespace lve {
+
+// instruction sets the batch kernels are written for, picked at runtime
+enum class LveSimdLevel {
+	Scalar,
+	Sse2,	// 4 transforms per iteration
+	Avx2,	// 8, with fma
+	Avx512,	// 16
+};
+
+// best level both compiled in and supported by the running cpu
+LveSimdLevel detectSimdLevel();
+const char *getSimdLevelName(LveSimdLevel level);
+
+// sin and cos with the same approximation the kernels use,
+// max absolute error below 1e-6 for |x| <= 8192, degrades slowly beyond
+void fastSinCos(float x, float &s, float &c);
+
+// rotation * scale matrices for count transforms, the batch version of transform2dMatrix.
+// scales are interleaved xy pairs (glm::vec2), out gets 4 floats per transform in glm::mat2 column order.
+void computeTransforms2d(const float *scales, const float *rotations, uint32_t count, float *out);
+// same with a fixed level, for benchmarks and accuracy checks, the level has to be supported
+void computeTransforms2d(const float *scales, const float *rotations, uint32_t count, float *out, LveSimdLevel level);
+
+}
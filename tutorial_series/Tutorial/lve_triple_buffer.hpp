@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace lve {
+
+// single producer single consumer handoff of the latest value, neither side ever blocks.
+// The producer fills the back buffer and publishes it, the consumer picks up whatever was
+// published last, values published in between are dropped.
+template<typename T>
+class LveTripleBuffer {
+public:
+	LveTripleBuffer() = default;
+
+	// deleting copy constructors, both threads hold references into it
+	LveTripleBuffer(const LveTripleBuffer&) = delete;
+	LveTripleBuffer operator=(const LveTripleBuffer&) = delete;
+
+	// producer side, only valid until the next publish
+	T &getBackBuffer() { return buffers[backIndex]; }
+	// every buffer's contents, for a producer that wants to know what the others last held.
+	// Only the fields it wrote itself are safe to read, the consumer may be using one of them.
+	const T &getBuffer(uint32_t index) const { return buffers[index]; }
+
+	// swaps the back buffer into the middle, the previous middle becomes the new back buffer
+	void publish(){
+		uint8_t previous = state.exchange(static_cast<uint8_t>(backIndex | FRESH_BIT), std::memory_order_acq_rel);
+		backIndex = previous & INDEX_MASK;
+	}
+
+	// consumer side, takes the latest published buffer, false if nothing new was published
+	bool acquire(){
+		if((state.load(std::memory_order_relaxed) & FRESH_BIT) == 0){
+			return false;
+		}
+		uint8_t previous = state.exchange(frontIndex, std::memory_order_acq_rel);
+		frontIndex = previous & INDEX_MASK;
+		return true;
+	}
+	// stays valid until the next acquire
+	const T &getFrontBuffer() const { return buffers[frontIndex]; }
+
+private:
+	static constexpr uint8_t INDEX_MASK = 0x3;
+	static constexpr uint8_t FRESH_BIT = 0x4;
+
+	std::array<T, 3> buffers{};
+	// index of the middle buffer and whether it was published since the consumer last took it
+	std::atomic<uint8_t> state{1};
+	uint8_t backIndex = 0;	// producer only
+	uint8_t frontIndex = 2;	// consumer only
+};
+
+}
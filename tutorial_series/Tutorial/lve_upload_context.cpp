@@ -0,0 +1,220 @@
+#include "lve_upload_context.hpp"
+#include "lve_device.hpp"
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace lve {
+
+LveUploadContext::LveUploadContext(LveDevice &device) : lveDevice(device){
+	createCommandPool();
+}
+
+LveUploadContext::~LveUploadContext(){
+	if(isRecording){
+		submit();
+	}
+	waitIdle();
+
+	for(auto &batch : freeBatches){
+		vkDestroyFence(lveDevice.device(), batch.fence, nullptr);
+	}
+	vkDestroyCommandPool(lveDevice.device(), commandPool, nullptr);
+}
+
+void LveUploadContext::createCommandPool(){
+	// own pool so uploads never touch the pool the renderer records from
+	VkCommandPoolCreateInfo poolInfo{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+		.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+		.queueFamilyIndex = lveDevice.findPhysicalQueueFamilies().graphicsFamily,
+	};
+
+	if(vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS){
+		throw std::runtime_error("Failed to create upload command pool");
+	}
+}
+
+VkCommandBuffer LveUploadContext::beginRecording(){
+	if(isRecording){
+		return openBatch.commandBuffer;
+	}
+
+	collectFinishedBatches();
+
+	// a finished batch's fence may still be waited on by a thread that looked it up before, reusing it would reset it
+	if(!freeBatches.empty() && waitingThreads == 0){
+		openBatch = std::move(freeBatches.back());
+		freeBatches.pop_back();
+		vkResetCommandBuffer(openBatch.commandBuffer, 0);
+		vkResetFences(lveDevice.device(), 1, &openBatch.fence);
+	}
+	else{
+		openBatch = Batch{};
+		VkCommandBufferAllocateInfo allocInfo{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+			.commandPool = commandPool,
+			.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+			.commandBufferCount = 1,
+		};
+		if(vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &openBatch.commandBuffer) != VK_SUCCESS){
+			throw std::runtime_error("Failed to allocate upload command buffer");
+		}
+
+		VkFenceCreateInfo fenceInfo{
+			.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+		};
+		if(vkCreateFence(lveDevice.device(), &fenceInfo, nullptr, &openBatch.fence) != VK_SUCCESS){
+			throw std::runtime_error("Failed to create upload fence");
+		}
+	}
+
+	VkCommandBufferBeginInfo beginInfo{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+		.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+	};
+	if(vkBeginCommandBuffer(openBatch.commandBuffer, &beginInfo) != VK_SUCCESS){
+		throw std::runtime_error("Failed to begin upload command buffer");
+	}
+
+	isRecording = true;
+	return openBatch.commandBuffer;
+}
+
+void LveUploadContext::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset){
+	std::lock_guard<std::mutex> lock(mutex);
+	auto commandBuffer = beginRecording();
+
+	VkBufferCopy copyRegion{
+		.srcOffset = srcOffset,
+		.dstOffset = dstOffset,
+		.size = size,
+	};
+	vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+}
+
+void LveUploadContext::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount){
+	std::lock_guard<std::mutex> lock(mutex);
+	auto commandBuffer = beginRecording();
+
+	// image has to already be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+	VkBufferImageCopy region{
+		.bufferOffset = 0,
+		.bufferRowLength = 0,
+		.bufferImageHeight = 0,
+		.imageSubresource = {
+			.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+			.mipLevel = 0,
+			.baseArrayLayer = 0,
+			.layerCount = layerCount,
+		},
+		.imageOffset = {0, 0, 0},
+		.imageExtent = {width, height, 1},
+	};
+	vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+}
+
+void LveUploadContext::releaseAfterUpload(VkBuffer buffer, LveAllocation allocation){
+	std::lock_guard<std::mutex> lock(mutex);
+	beginRecording();
+	openBatch.staging.emplace_back(buffer, allocation);
+}
+
+LveUploadContext::Ticket LveUploadContext::submit(){
+	std::lock_guard<std::mutex> lock(mutex);
+	if(!isRecording){
+		// nothing new recorded, the last handed out ticket covers everything
+		return nextTicket - 1;
+	}
+
+	// make the copies visible to anything submitted after this batch on the same queue
+	VkMemoryBarrier barrier{
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+	};
+	vkCmdPipelineBarrier(openBatch.commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+		1, &barrier,
+		0, nullptr,
+		0, nullptr);
+
+	if(vkEndCommandBuffer(openBatch.commandBuffer) != VK_SUCCESS){
+		throw std::runtime_error("Failed to record upload command buffer");
+	}
+
+	VkSubmitInfo submitInfo{
+		.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+		.commandBufferCount = 1,
+		.pCommandBuffers = &openBatch.commandBuffer,
+	};
+	std::lock_guard<std::mutex> queueLock(lveDevice.queueMutex());
+	if(vkQueueSubmit(lveDevice.graphicsQueue(), 1, &submitInfo, openBatch.fence) != VK_SUCCESS){
+		throw std::runtime_error("Failed to submit upload command buffer");
+	}
+
+	openBatch.ticket = nextTicket++;
+	Ticket ticket = openBatch.ticket;
+	inFlightBatches.push_back(std::move(openBatch));
+	openBatch = Batch{};
+	isRecording = false;
+
+	return ticket;
+}
+
+bool LveUploadContext::isComplete(Ticket ticket){
+	std::lock_guard<std::mutex> lock(mutex);
+	assert(ticket < nextTicket && "Ticket was never handed out");
+	collectFinishedBatches();
+	return ticket <= completedTicket;
+}
+
+void LveUploadContext::wait(Ticket ticket){
+	std::unique_lock<std::mutex> lock(mutex);
+	assert(ticket < nextTicket && "Ticket was never handed out");
+
+	std::vector<VkFence> fences;
+	for(auto &batch : inFlightBatches){
+		if(batch.ticket <= ticket){
+			fences.push_back(batch.fence);
+		}
+	}
+
+	if(!fences.empty()){
+		// other threads keep recording and submitting meanwhile, beginRecording doesn't reset fences while anyone waits
+		waitingThreads++;
+		lock.unlock();
+		vkWaitForFences(lveDevice.device(), static_cast<uint32_t>(fences.size()), fences.data(), VK_TRUE, std::numeric_limits<uint64_t>::max());
+		lock.lock();
+		waitingThreads--;
+	}
+	collectFinishedBatches();
+}
+
+void LveUploadContext::waitIdle(){
+	wait(nextTicket - 1);
+}
+
+void LveUploadContext::collectFinishedBatches(){
+	// batches are retired in submission order so completedTicket never skips an unfinished one
+	while(!inFlightBatches.empty() && vkGetFenceStatus(lveDevice.device(), inFlightBatches.front().fence) == VK_SUCCESS){
+		completedTicket = inFlightBatches.front().ticket;
+		releaseBatch(inFlightBatches.front());
+		freeBatches.push_back(std::move(inFlightBatches.front()));
+		inFlightBatches.pop_front();
+	}
+}
+
+void LveUploadContext::releaseBatch(Batch &batch){
+	for(auto &[buffer, allocation] : batch.staging){
+		vkDestroyBuffer(lveDevice.device(), buffer, nullptr);
+		lveDevice.freeMemory(allocation);
+	}
+	batch.staging.clear();
+}
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "lve_device.hpp"
+
+namespace lve {
+
+// batches many transfer commands into one submission, instead of one queue round-trip per copy
+class LveUploadContext {
+public:
+	// monotonically increasing, a ticket is done once every batch up to it finished on the GPU
+	using Ticket = uint64_t;
+
+	LveUploadContext(LveDevice &device);
+	~LveUploadContext();
+
+	// deleting copy constructors to prevent vulkan object cloning
+	LveUploadContext(const LveUploadContext&) = delete;
+	LveUploadContext operator=(const LveUploadContext&) = delete;
+
+	// recorded into the open batch, nothing reaches the GPU until submit()
+	void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
+	void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
+	// staging buffers are destroyed once the batch they were used in completes
+	void releaseAfterUpload(VkBuffer buffer, LveAllocation allocation);
+
+	// submits the open batch with its own fence and returns the ticket to wait on
+	Ticket submit();
+	bool isComplete(Ticket ticket);
+	// blocks without holding the context, other threads can record and submit in the meantime
+	void wait(Ticket ticket);
+	void waitIdle();
+
+private:
+	struct Batch {
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		VkFence fence = VK_NULL_HANDLE;
+		Ticket ticket = 0;
+		std::vector<std::pair<VkBuffer, LveAllocation>> staging;
+	};
+
+	LveDevice &lveDevice;
+	VkCommandPool commandPool;
+	Batch openBatch;
+	bool isRecording = false;
+	std::deque<Batch> inFlightBatches;
+	std::vector<Batch> freeBatches; // finished batches keep their command buffer and fence for reuse
+	Ticket nextTicket = 1;
+	Ticket completedTicket = 0;
+	uint32_t waitingThreads = 0; // inside wait() with the mutex released
+	std::mutex mutex;
+
+	void createCommandPool();
+	VkCommandBuffer beginRecording();
+	void collectFinishedBatches();
+	void releaseBatch(Batch &batch);
+};
+
+}
@@ -1,6 +1,8 @@
 #include "lve_window.hpp"
 #include <GLFW/glfw3.h>
+#include <chrono>
 #include <stdexcept>
+#include <thread>
 #include <vulkan/vulkan_core.h>
 
 namespace lve {
@@ -34,6 +36,15 @@ void LveWindow::createWindowSurface(VkInstance instance, VkSurfaceKHR *surface){
 	}
 }
 
+void LveWindow::waitEvents(){
+	if(std::this_thread::get_id() == mainThread){
+		glfwWaitEvents();
+	}
+	else{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+}
+
 void LveWindow::framebufferResizeCalllback(GLFWwindow *window, int width, int height){
 	auto lveWindow = reinterpret_cast<LveWindow *>(glfwGetWindowUserPointer(window));
 	lveWindow->framebufferResised = true;
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <string>
+#include <thread>
 #include <vulkan/vulkan_core.h>
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
@@ -20,11 +22,14 @@ public:
 
 	// glfw window forward
 	bool shouldClose(){ return  glfwWindowShouldClose(window);}
-	VkExtent2D getExtent() {return {static_cast<uint32_t>(width), static_cast<uint32_t>(height)}; };
-	bool wasWindowResized() {return framebufferResised;};
-	void resetWindowResizedFlag() {framebufferResised = false;};
+	// the size and resize flag are written by glfw callbacks on the main thread, safe to read from a render thread
+	VkExtent2D getExtent() {return {static_cast<uint32_t>(width.load()), static_cast<uint32_t>(height.load())}; };
+	// returns whether the window was resized since the last call, checking and clearing the flag in one step
+	bool consumeWindowResizedFlag() {return framebufferResised.exchange(false);};
 
 	void createWindowSurface(VkInstance instance, VkSurfaceKHR *surface);
+	// blocks for window events, glfw only allows that on the main thread so other threads just back off a bit
+	void waitEvents();
 
 private:
 	// simple window initialization
@@ -32,9 +37,10 @@ private:
 	static void framebufferResizeCalllback(GLFWwindow *window, int width, int height);
 
 	// window parameters
-	int width;  // cosnt for now resizing is a headache for later
-	int height; // cosnt for now resizing is a headache for later
-	bool framebufferResised = false;
+	std::atomic<int> width;
+	std::atomic<int> height;
+	std::atomic<bool> framebufferResised{false};
+	std::thread::id mainThread = std::this_thread::get_id();
 	std::string windowName;
 
 	// pointer to the actual window object
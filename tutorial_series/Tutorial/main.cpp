@@ -1,17 +1,72 @@
 #include "first_app.hpp"
 #include <exception>
 
+#include <cstdint>
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
+
+// std::stoul takes a leading minus and wraps around, counts have to be positive and fit a uint32_t
+static uint32_t parseCount(const std::string &value)
+{
+    unsigned long count = std::stoul(value);
+    if (value.find('-') != std::string::npos || count > UINT32_MAX) {
+        throw std::out_of_range(value);
+    }
+    return static_cast<uint32_t>(count);
+}
 
 int main(int argc, char const *argv[])
 {
     // initialize the app
-    lve::FirstApp app{};
+    lve::FirstAppOptions options{};
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        // a bad number for the numeric options throws out of std::stof/parseCount
+        try {
+            if (arg == "--render-thread") {
+                // record and submit frames on a thread of their own
+                options.renderThread = true;
+            } else if (arg == "--gpu-profile") {
+                options.gpuProfile = true;
+            } else if (arg == "--trace" && i + 1 < argc) {
+                // open the file in ui.perfetto.dev or chrome://tracing
+                options.tracePath = argv[++i];
+            } else if (arg == "--trace-hitch-ms" && i + 1 < argc) {
+                options.hitchMs = std::stof(argv[++i]);
+            } else if (arg == "--headless") {
+                // no window or display needed, VK_ICD_FILENAMES can point the loader at lavapipe
+                options.headless = true;
+            } else if (arg == "--frames" && i + 1 < argc) {
+                options.frameCount = parseCount(argv[++i]);
+            } else if (arg == "--output" && i + 1 < argc) {
+                options.outputPath = argv[++i];
+            } else if (arg == "--sierpinski" && i + 1 < argc) {
+                options.sierpinskiDepth = parseCount(argv[++i]);
+            } else if (arg == "--compute-geometry") {
+                options.computeGeometry = true;
+            } else {
+                std::cerr << "unknown option " << arg << '\n';
+                return EXIT_FAILURE;
+            }
+        } catch (const std::logic_error &) {
+            std::cerr << "invalid value " << argv[i] << " for " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+    if (!options.outputPath.empty() && !options.headless) {
+        std::cerr << "--output needs --headless\n";
+        return EXIT_FAILURE;
+    }
+    // nothing would ever close a headless run
+    if (options.headless && options.frameCount == 0) {
+        options.frameCount = 1000;
+    }
 
-    // try running it and chatch and print errors
+    // try running it and chatch and print errors, loading the scene can already fail
     try {
+        lve::FirstApp app{options};
         app.run();
     } catch (const std::exception &e) {
         std::cerr << e.what() << '\n';
@@ -1,13 +1,9 @@
 #version 450
 
-layout(location = 0) out vec4 outColor;
+layout(location = 0) in vec3 fragColor;
 
-layout(push_constant) uniform Push {
-	mat2 transform;
-	vec2 offset;
-	vec3 color;
-} push;
+layout(location = 0) out vec4 outColor;
 
 void main(){
-	outColor = vec4(push.color, 1.0);
+	outColor = vec4(fragColor, 1.0);
 }
\ No newline at end of file
@@ -3,12 +3,14 @@
 layout(location = 0) in vec2 position;
 layout(location = 1) in vec3 color;
 
-layout(push_constant) uniform Push {
-	mat2 transform;
-	vec2 offset;
-	vec3 color;
-} push;
+// per instance attributes, mat2 takes locations 2 and 3
+layout(location = 2) in mat2 transform;
+layout(location = 4) in vec2 offset;
+layout(location = 5) in vec3 instanceColor;
+
+layout(location = 0) out vec3 fragColor;
 
 void main(){
-	gl_Position = vec4(push.transform * position + push.offset, 0.0, 1.0);
+	gl_Position = vec4(transform * position + offset, 0.0, 1.0);
+	fragColor = instanceColor;
 }
\ No newline at end of file
@@ -1,16 +1,20 @@
 #include "simple_render_system.hpp"
 #include "lve_device.hpp"
-#include "lve_game_object.hpp"
+#include "lve_gpu_profiler.hpp"
+#include "lve_scene_snapshot.hpp"
 #include "lve_model.hpp"
 #include "lve_pipeline.hpp"
+#include "lve_profiler.hpp"
 #include "lve_swap_chain.hpp"
+#include "lve_transform_batch.hpp"
 #include <GLFW/glfw3.h>
 #include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
-#include <glm/common.hpp>
+#include <cmath>
+#include <functional>
 #include <glm/fwd.hpp>
 #include <memory>
 #include <stdexcept>
@@ -23,37 +27,29 @@
 
 namespace lve {
 
-struct SimplePushConstantData {
-	glm::mat2 trasform{1.f};
-	glm::vec2 offset;
-	alignas(16) glm::vec3 color;
-};
-
 SimpleRenderSystem::SimpleRenderSystem(LveDevice& device, VkRenderPass renderPass) : lveDevice(device){
 	createPipelineLayout();
 	createPipeline(renderPass);
+	instanceBuffers.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
 }
 
 SimpleRenderSystem::~SimpleRenderSystem(){
+	for(auto& instanceBuffer : instanceBuffers){
+		destroyInstanceBuffer(instanceBuffer);
+	}
 	vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
 }
 
 void SimpleRenderSystem::createPipelineLayout(){
 
-	VkPushConstantRange pushConstantRange{
-		.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-		.offset = 0,
-		.size = sizeof(SimplePushConstantData),
-	};
-
-
+	// per object data comes in through the instance buffer, no push constants needed
 	VkPipelineLayoutCreateInfo pipelineLayoutInfo{
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
 		// passing info like textures, UOB, ect
 		.setLayoutCount = 0,
 		.pSetLayouts = nullptr,
-		.pushConstantRangeCount = 1,
-		.pPushConstantRanges = &pushConstantRange,
+		.pushConstantRangeCount = 0,
+		.pPushConstantRanges = nullptr,
 	};
 
 	if(vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS){
@@ -64,37 +60,234 @@ void SimpleRenderSystem::createPipelineLayout(){
 void SimpleRenderSystem::createPipeline(VkRenderPass renderPass){
 	assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
-	PipelineConfigInfo pipelineConfig{};
-	LvePipeline::defaultPipelineConfngInfo(pipelineConfig);
-	pipelineConfig.renderPass = renderPass;
-	pipelineConfig.pipelineLayout = pipelineLayout;
+	for(uint32_t i = 0; i < LveModel::VERTEX_LAYOUT_COUNT; i++){
+		auto layout = static_cast<LveModel::VertexLayout>(i);
+
+		PipelineConfigInfo pipelineConfig{};
+		LvePipeline::defaultPipelineConfngInfo(pipelineConfig);
+		pipelineConfig.renderPass = renderPass;
+		pipelineConfig.pipelineLayout = pipelineLayout;
+		pipelineConfig.bindingDescriptions = LveModel::Vertex::getBindingDescriptions(layout);
+		pipelineConfig.attributeDescriptions = LveModel::Vertex::getAttributeDescriptions(layout);
+
+		lvePipelines[i] = std::make_unique<LvePipeline>(lveDevice,"shaders/simple_shader.vert.spv","shaders/simple_shader.frag.spv",pipelineConfig);
+	}
+}
+
+void SimpleRenderSystem::reserveInstances(InstanceBuffer &instanceBuffer, uint32_t instanceCount){
+	if(instanceCount <= instanceBuffer.capacity){
+		return;
+	}
+
+	// the fence for this frame index was already waited on in beginFrame, so the old buffer is free
+	destroyInstanceBuffer(instanceBuffer);
+	instanceBuffer.capacity = std::max({instanceCount, instanceBuffer.capacity * 2, 64u});
+
+	lveDevice.createBuffer(
+		sizeof(LveModel::InstanceData) * instanceBuffer.capacity,
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		instanceBuffer.buffer,
+		instanceBuffer.memory
+	);
+}
+
+void SimpleRenderSystem::destroyInstanceBuffer(InstanceBuffer &instanceBuffer){
+	if(instanceBuffer.buffer == VK_NULL_HANDLE){
+		return;
+	}
+	vkDestroyBuffer(lveDevice.device(), instanceBuffer.buffer, nullptr);
+	lveDevice.freeMemory(instanceBuffer.memory);
+	instanceBuffer.buffer = VK_NULL_HANDLE;
+	instanceBuffer.capacity = 0;
+	instanceBuffer.rewriteAll = true;
+}
+
+void SimpleRenderSystem::rebuildLayout(const LveSceneSnapshot &scene){
+	LVE_PROFILE_ZONE("rebuild layout");
+	// group objects sharing a model next to each other
+	drawOrder.resize(scene.size());
+	for(uint32_t i = 0; i < drawOrder.size(); i++){
+		drawOrder[i] = i;
+	}
+	auto models = scene.models();
+	std::sort(drawOrder.begin(), drawOrder.end(), [&](uint32_t a, uint32_t b){
+		auto modelA = models[a].get();
+		auto modelB = models[b].get();
+		return modelA != modelB ? std::less<LveModel*>{}(modelA, modelB) : a < b;
+	});
+	instanceIndices.resize(drawOrder.size());
+	for(uint32_t i = 0; i < drawOrder.size(); i++){
+		instanceIndices[drawOrder[i]] = i;
+	}
+	transforms.resize(scene.size());
+	translations.resize(scene.size());
+
+	for(auto& instanceBuffer : instanceBuffers){
+		instanceBuffer.rewriteAll = true;
+		instanceBuffer.pendingSlots.clear();
+	}
+	layoutVersion = scene.getLayoutVersion();
+}
+
+void SimpleRenderSystem::updateTransforms(const LveSceneSnapshot &scene, const uint32_t *slots, uint32_t count, float interpolation){
+	LVE_PROFILE_ZONE("update transforms");
+	auto scales = scene.scales();
+	auto rotations = scene.rotations();
+	auto currentTranslations = scene.translations();
+	auto previousScales = scene.previousScales();
+	auto previousRotations = scene.previousRotations();
+	auto previousTranslations = scene.previousTranslations();
+
+	// gather, batch and scatter, so a few updates don't pay for the whole store
+	updatedScales.resize(count);
+	updatedRotations.resize(count);
+	updatedTransforms.resize(count);
+	for(uint32_t i = 0; i < count; i++){
+		uint32_t slot = slots[i];
+		float delta = rotations[slot] - previousRotations[slot];
+		// wrapped angles would otherwise spin the long way round
+		if(std::abs(delta) > glm::pi<float>()){
+			delta = std::remainder(delta, glm::two_pi<float>());
+		}
+		updatedScales[i] = glm::mix(previousScales[slot], scales[slot], interpolation);
+		updatedRotations[i] = previousRotations[slot] + delta * interpolation;
+		translations[slot] = glm::mix(previousTranslations[slot], currentTranslations[slot], interpolation);
+	}
 
-	lvePipeline = std::make_unique<LvePipeline>(lveDevice,"shaders/simple_shader.vert.spv","shaders/simple_shader.frag.spv",pipelineConfig);
+	// the mat2 columns are read as 4 plain floats by the batch kernel
+	static_assert(sizeof(glm::mat2) == 4 * sizeof(float), "glm::mat2 has to be tightly packed");
+	computeTransforms2d(
+		reinterpret_cast<const float*>(updatedScales.data()),
+		updatedRotations.data(),
+		count,
+		reinterpret_cast<float*>(updatedTransforms.data())
+	);
+	for(uint32_t i = 0; i < count; i++){
+		transforms[slots[i]] = updatedTransforms[i];
+	}
 }
 
-void SimpleRenderSystem::renderGameObjects(VkCommandBuffer commandBuffer, std::vector<LveGameObject> &gameObjects){
-	lvePipeline->bind(commandBuffer);
-
-	for(auto& obj: gameObjects){
-		obj.transform2d.rotation = glm::mod(obj.transform2d.rotation + 0.01f, glm::two_pi<float>());
-	}
-
-	for(auto& obj: gameObjects){
-		SimplePushConstantData push{
-			.trasform = obj.transform2d.mat2(),
-			.offset = obj.transform2d.translation,
-			.color = obj.color,
-		};
-
-		vkCmdPushConstants(
-			commandBuffer,
-			pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 
-			0, 
-			sizeof(SimplePushConstantData), 
-			&push
-		);
-		obj.model->bind(commandBuffer);
-		obj.model->draw(commandBuffer);
+void SimpleRenderSystem::writeInstance(LveModel::InstanceData *instances, const LveSceneSnapshot &scene, uint32_t slot) const {
+	auto& model = scene.models()[slot];
+	const glm::mat2 &transform = transforms[slot];
+	// packed positions are decoded by the instance transform, model * (p * scale + offset)
+	glm::vec2 decodeScale = model->getDecodeScale();
+	instances[instanceIndices[slot]] = {
+		.transform = glm::mat2{transform[0] * decodeScale.x, transform[1] * decodeScale.y},
+		.offset = transform * model->getDecodeOffset() + translations[slot],
+		.color = scene.colors()[slot],
+	};
+}
+
+void SimpleRenderSystem::renderGameObjects(FrameInfo &frameInfo, const LveSceneSnapshot &scene){
+	LVE_PROFILE_ZONE("render game objects");
+	// the change list only helps if it starts from what was rendered last
+	if(scene.getLayoutVersion() != layoutVersion || lastSequence < scene.getBaseSequence()){
+		rebuildLayout(scene);
+		updateTransforms(scene, drawOrder.data(), static_cast<uint32_t>(drawOrder.size()), frameInfo.interpolation);
+	}
+	else{
+		// moving objects are re-blended every frame, others only when they changed or just settled
+		auto& movingSlots = scene.getMovingSlots();
+		updatedSlots.assign(movingSlots.begin(), movingSlots.end());
+		if(scene.getSequence() != lastSequence){
+			updatedSlots.insert(updatedSlots.end(), scene.getChangedSlots().begin(), scene.getChangedSlots().end());
+		}
+		updateTransforms(scene, updatedSlots.data(), static_cast<uint32_t>(updatedSlots.size()), frameInfo.interpolation);
+
+		// every frame in flight has its own copy of the instances, each one catches up when it is next used
+		for(auto& instanceBuffer : instanceBuffers){
+			if(!instanceBuffer.rewriteAll){
+				instanceBuffer.pendingSlots.insert(instanceBuffer.pendingSlots.end(), updatedSlots.begin(), updatedSlots.end());
+			}
+		}
+	}
+	lastSequence = scene.getSequence();
+
+	if(scene.empty()){
+		return;
+	}
+
+	auto& instanceBuffer = instanceBuffers[frameInfo.frameIndex];
+	reserveInstances(instanceBuffer, static_cast<uint32_t>(scene.size()));
+
+	// patch just the changed instances, unless so many changed that a full rewrite is cheaper
+	uint32_t objectCount = static_cast<uint32_t>(drawOrder.size());
+	bool rewriteAll = instanceBuffer.rewriteAll || instanceBuffer.pendingSlots.size() >= objectCount / 2;
+	if(!rewriteAll){
+		LVE_PROFILE_ZONE("patch instances");
+		auto instances = static_cast<LveModel::InstanceData*>(instanceBuffer.memory.mapped);
+		for(uint32_t slot : instanceBuffer.pendingSlots){
+			writeInstance(instances, scene, slot);
+		}
+	}
+	instanceBuffer.pendingSlots.clear();
+	instanceBuffer.rewriteAll = false;
+
+	auto gpuProfiler = frameInfo.gpuProfiler;
+	if(frameInfo.parallelRecorder == nullptr){
+		LveGpuProfiler::Scope scope{gpuProfiler, frameInfo.commandBuffer, "simple render system"};
+		recordObjects(frameInfo.commandBuffer, scene, instanceBuffer, 0, objectCount, rewriteAll);
+		return;
+	}
+
+	// the primary may only execute secondaries, so the timestamps go into the first and the last one
+	uint32_t scope = gpuProfiler ? gpuProfiler->beginScope("simple render system") : LveGpuProfiler::INVALID_SCOPE;
+
+	// too few objects per task costs more in scheduling than it saves, surplus tasks don't record at all
+	constexpr uint32_t MIN_OBJECTS_PER_TASK = 1024;
+	uint32_t taskCount = std::clamp(objectCount / MIN_OBJECTS_PER_TASK, 1u, frameInfo.parallelRecorder->getTaskCount());
+	uint32_t lastTask = taskCount - 1;
+	frameInfo.parallelRecorder->record(frameInfo.commandBuffer, taskCount, [&](VkCommandBuffer commandBuffer, uint32_t task){
+		if(gpuProfiler && task == 0){
+			gpuProfiler->writeBeginTimestamp(commandBuffer, scope);
+		}
+		uint32_t begin = static_cast<uint32_t>(uint64_t(objectCount) * task / taskCount);
+		uint32_t end = static_cast<uint32_t>(uint64_t(objectCount) * (task + 1) / taskCount);
+		recordObjects(commandBuffer, scene, instanceBuffer, begin, end, rewriteAll);
+		if(gpuProfiler && task == lastTask){
+			gpuProfiler->writeEndTimestamp(commandBuffer, scope);
+		}
+	});
+	if(gpuProfiler){
+		gpuProfiler->endScope();
+	}
+}
+
+void SimpleRenderSystem::recordObjects(VkCommandBuffer commandBuffer, const LveSceneSnapshot &scene, InstanceBuffer &instanceBuffer, uint32_t begin, uint32_t end, bool writeInstances){
+	LVE_PROFILE_ZONE("record objects");
+	auto models = scene.models();
+
+	if(writeInstances){
+		auto instances = static_cast<LveModel::InstanceData*>(instanceBuffer.memory.mapped);
+		for(uint32_t i = begin; i < end; i++){
+			writeInstance(instances, scene, drawOrder[i]);
+		}
+	}
+
+	VkBuffer buffers[] = {instanceBuffer.buffer};
+	VkDeviceSize offsets[] = {0};
+	vkCmdBindVertexBuffers(commandBuffer, 1, 1, buffers, offsets);
+	LvePipeline* boundPipeline = nullptr;
+
+	// one instanced draw per run of objects sharing a model, runs crossing the range end are split
+	uint32_t groupStart = begin;
+	while(groupStart < end){
+		auto& model = models[drawOrder[groupStart]];
+		uint32_t groupEnd = groupStart + 1;
+		while(groupEnd < end && models[drawOrder[groupEnd]] == model){
+			groupEnd++;
+		}
+
+		auto pipeline = lvePipelines[static_cast<uint32_t>(model->getLayout())].get();
+		if(pipeline != boundPipeline){
+			pipeline->bind(commandBuffer);
+			boundPipeline = pipeline;
+		}
+		model->bind(commandBuffer);
+		model->draw(commandBuffer, groupEnd - groupStart, groupStart);
+		groupStart = groupEnd;
 	}
 
 }
@@ -1,12 +1,16 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
 #include "lve_pipeline.hpp"
 #include "lve_device.hpp"
-#include "lve_game_object.hpp"
+#include "lve_frame_info.hpp"
+#include "lve_model.hpp"
+#include "lve_scene_snapshot.hpp"
 
 namespace lve {
 class SimpleRenderSystem{
@@ -18,14 +22,49 @@ public:
 	SimpleRenderSystem(const SimpleRenderSystem&) = delete;
 	SimpleRenderSystem operator=(const SimpleRenderSystem&) = delete;
 
-	void renderGameObjects(VkCommandBuffer commandBuffer, std::vector<LveGameObject> &gameObjects);
+	// objects sharing a model are drawn with a single instanced draw,
+	// with a parallel recorder the sorted objects are split into one contiguous range per recording task.
+	// Only objects changed since the last rendered snapshot and moving ones get their transform and instance
+	// rewritten, transforms are blended between the previous and current simulation step by frameInfo.interpolation.
+	void renderGameObjects(FrameInfo &frameInfo, const LveSceneSnapshot &scene);
 private:
+	// per frame in flight, host visible and persistently mapped
+	struct InstanceBuffer {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		LveAllocation memory;
+		uint32_t capacity = 0;
+		bool rewriteAll = true;				// contents don't match the current draw order
+		std::vector<uint32_t> pendingSlots;	// changed since this buffer was last written
+	};
+
 	// our window object created on instance
 	LveDevice &lveDevice;
-	std::unique_ptr<LvePipeline> lvePipeline;
+	// one per vertex layout, they only differ in their vertex input formats
+	std::array<std::unique_ptr<LvePipeline>, LveModel::VERTEX_LAYOUT_COUNT> lvePipelines;
 	VkPipelineLayout pipelineLayout;
+	std::vector<InstanceBuffer> instanceBuffers;
+	// everything below is cached per layout version and patched with the snapshots' change lists in between
+	uint32_t layoutVersion = UINT32_MAX;
+	uint64_t lastSequence = 0;
+	std::vector<uint32_t> drawOrder;		// object slots sorted by model
+	std::vector<uint32_t> instanceIndices;	// inverse of drawOrder, slot -> instance
+	std::vector<glm::mat2> transforms;		// interpolated rotation * scale per slot
+	std::vector<glm::vec2> translations;	// interpolated translation per slot
+	// gathered inputs and outputs for batching the transforms of updated slots
+	std::vector<uint32_t> updatedSlots;
+	std::vector<glm::vec2> updatedScales;
+	std::vector<float> updatedRotations;
+	std::vector<glm::mat2> updatedTransforms;
 
 	void createPipelineLayout();
 	void createPipeline(VkRenderPass renderPass);
+	void reserveInstances(InstanceBuffer &instanceBuffer, uint32_t instanceCount);
+	void destroyInstanceBuffer(InstanceBuffer &instanceBuffer);
+	void rebuildLayout(const LveSceneSnapshot &scene);
+	// interpolates the given slots into transforms and translations
+	void updateTransforms(const LveSceneSnapshot &scene, const uint32_t *slots, uint32_t count, float interpolation);
+	void writeInstance(LveModel::InstanceData *instances, const LveSceneSnapshot &scene, uint32_t slot) const;
+	// records the draws of drawOrder[begin, end), writing their instances first when writeInstances is set
+	void recordObjects(VkCommandBuffer commandBuffer, const LveSceneSnapshot &scene, InstanceBuffer &instanceBuffer, uint32_t begin, uint32_t end, bool writeInstances);
 };
 }
\ No newline at end of file
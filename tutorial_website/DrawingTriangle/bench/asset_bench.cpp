@@ -0,0 +1,110 @@
+// asset loading steps of the app on its own files: texture decoding, OBJ parsing, vertex welding and mesh optimization
+// usage: asset_bench.out [harness options, see bench.hpp], run from this directory
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.hpp>
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+#include "../mesh_optimizer.hpp"
+#include "../vertex_weld.hpp"
+#include "bench.hpp"
+
+// same layout as the app's Vertex, without pulling in glm
+struct Vertex{
+    float pos[3];
+    float color[3];
+    float texCoord[2];
+};
+
+struct Model{
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+};
+
+Model loadModel(const char* path){
+    Model model;
+    std::string warn, err;
+    if(!tinyobj::LoadObjParallel(&model.attrib, &model.shapes, &model.materials, &warn, &err, path)){
+        throw std::runtime_error(warn+err);
+    }
+    return model;
+}
+
+// one vertex per index, like parseModel before welding
+std::vector<Vertex> expandModel(const Model& model){
+    std::vector<Vertex> expanded;
+    for(const auto& shape : model.shapes){
+        for(const auto& index : shape.mesh.indices){
+            const float* position = &model.attrib.vertices[3 * index.vertex_index];
+            const float* texCoord = &model.attrib.texcoords[2 * index.texcoord_index];
+            // + 0.0f turns -0.0f into 0.0f, welding compares raw bytes
+            expanded.push_back({
+                {position[0] + 0.0f, position[1] + 0.0f, position[2] + 0.0f},
+                {1.0f, 1.0f, 1.0f},
+                {texCoord[0] + 0.0f, 1.0f - texCoord[1] + 0.0f},
+            });
+        }
+    }
+    return expanded;
+}
+
+int main(int argc, char** argv){
+    bench::Suite suite{"asset", argc, argv};
+
+    // mip levels are blitted on the GPU while the texture uploads, only decoding runs on the CPU
+    for(const char* path : {"textures/viking_room.png", "textures/texture.jpg"}){
+        int width = 0, height = 0, channels = 0;
+        if(!stbi_info(path, &width, &height, &channels)){
+            throw std::runtime_error(std::string("failed to read ") + path);
+        }
+        suite.run(std::string("stbi_load/") + path, [&]{
+            stbi_uc* pixels = stbi_load(path, &width, &height, &channels, STBI_rgb_alpha);
+            bench::doNotOptimize(pixels);
+            stbi_image_free(pixels);
+        }, static_cast<double>(width) * height);
+    }
+
+    const char* modelPath = "models/viking_room.obj";
+    suite.run("LoadObjParallel/viking_room", [&]{
+        auto model = loadModel(modelPath);
+        bench::doNotOptimize(model.attrib.vertices.data());
+    });
+
+    auto expanded = expandModel(loadModel(modelPath));
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    suite.run("weldVertices/viking_room", [&]{
+        vertices.clear();
+        indices.clear();
+        weld::weldVertices(expanded.data(), expanded.size(), vertices, indices, 0);
+        bench::doNotOptimize(indices.data());
+    }, static_cast<double>(expanded.size()));
+
+    // every pass starts from the welded order, optimizing an already optimized mesh is the cheap case
+    std::vector<uint32_t> optimized(indices.size());
+    suite.run("optimizeVertexCache/viking_room", [&]{
+        meshopt::optimizeVertexCache(optimized.data(), indices.data(), indices.size(), vertices.size());
+        bench::doNotOptimize(optimized.data());
+    }, static_cast<double>(indices.size() / 3));
+
+    suite.run("optimizeOverdraw/viking_room", [&]{
+        meshopt::optimizeOverdraw(optimized.data(), indices.data(), indices.size(), &vertices[0].pos[0], vertices.size(), sizeof(Vertex));
+        bench::doNotOptimize(optimized.data());
+    }, static_cast<double>(indices.size() / 3));
+
+    std::vector<Vertex> fetchOrdered(vertices.size());
+    suite.run("optimizeVertexFetch/viking_room", [&]{
+        optimized = indices;
+        size_t usedVertices = meshopt::optimizeVertexFetch(fetchOrdered.data(), optimized.data(), optimized.size(), vertices.data(), vertices.size(), sizeof(Vertex));
+        bench::doNotOptimize(usedVertices);
+    }, static_cast<double>(vertices.size()));
+
+    return suite.finish();
+}
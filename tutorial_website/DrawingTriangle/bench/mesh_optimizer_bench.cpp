@@ -0,0 +1,74 @@
+// vertex cache statistics of a scrambled grid mesh before and after each optimization pass
+// usage: mesh_optimizer_bench.out [grid size]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "../mesh_optimizer.hpp"
+
+struct Position{
+    float x, y, z;
+};
+
+void printStats(const char* label, const std::vector<uint32_t>& indices, size_t vertexCount, double ms){
+    auto fifo16 = meshopt::analyzeVertexCache(indices.data(), indices.size(), vertexCount, 16);
+    auto fifo32 = meshopt::analyzeVertexCache(indices.data(), indices.size(), vertexCount, 32);
+    printf("%-14s ACMR %.3f / %.3f  ATVR %.3f / %.3f  (fifo 16 / 32)  %8.1f ms\n", label, fifo16.acmr, fifo32.acmr, fifo16.atvr, fifo32.atvr, ms);
+}
+
+template<typename Fn>
+double timed(Fn fn){
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv){
+    int gridSize = argc > 1 ? atoi(argv[1]) : 512;
+
+    // a bumpy sheet, then triangles and vertices shuffled like a badly exported scan
+    std::vector<Position> vertices;
+    for(int y = 0; y < gridSize; y++){
+        for(int x = 0; x < gridSize; x++){
+            vertices.push_back({float(x), float(y), float((x * 7 + y * 3) % 5) * 0.1f});
+        }
+    }
+    std::vector<uint32_t> indices;
+    for(int y = 0; y + 1 < gridSize; y++){
+        for(int x = 0; x + 1 < gridSize; x++){
+            uint32_t a = y * gridSize + x, b = a + 1, c = a + gridSize, d = c + 1;
+            indices.insert(indices.end(), {a, b, c, b, d, c});
+        }
+    }
+    std::mt19937 rng(42);
+    std::vector<uint32_t> triangleOrder(indices.size() / 3);
+    for(size_t t = 0; t < triangleOrder.size(); t++){
+        triangleOrder[t] = static_cast<uint32_t>(t);
+    }
+    std::shuffle(triangleOrder.begin(), triangleOrder.end(), rng);
+    std::vector<uint32_t> shuffled(indices.size());
+    for(size_t t = 0; t < triangleOrder.size(); t++){
+        for(unsigned k = 0; k < 3; k++){
+            shuffled[3 * t + k] = indices[3 * triangleOrder[t] + k];
+        }
+    }
+    indices.swap(shuffled);
+
+    printf("%d x %d grid, %zu vertices, %zu triangles\n", gridSize, gridSize, vertices.size(), indices.size() / 3);
+    printStats("input", indices, vertices.size(), 0.0);
+
+    double ms = timed([&]{ meshopt::optimizeVertexCache(indices.data(), indices.data(), indices.size(), vertices.size()); });
+    printStats("vertex cache", indices, vertices.size(), ms);
+
+    ms = timed([&]{ meshopt::optimizeOverdraw(indices.data(), indices.data(), indices.size(), &vertices[0].x, vertices.size(), sizeof(Position)); });
+    printStats("overdraw", indices, vertices.size(), ms);
+
+    std::vector<Position> fetchOrdered(vertices.size());
+    size_t vertexCount = 0;
+    ms = timed([&]{ vertexCount = meshopt::optimizeVertexFetch(fetchOrdered.data(), indices.data(), indices.size(), vertices.data(), vertices.size(), sizeof(Position)); });
+    printStats("vertex fetch", indices, vertexCount, ms);
+
+    return vertexCount == vertices.size() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
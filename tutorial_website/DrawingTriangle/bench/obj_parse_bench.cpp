@@ -0,0 +1,142 @@
+// compares the serial and the parallel tinyobj loaders on a generated mesh
+// usage: obj_parse_bench.out [grid size]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+struct ObjResult{
+    bool ok;
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warn, err;
+};
+
+// grid of quads split into groups, with smoothing groups, materials, relative indices and mixed line endings
+std::string generateObj(int gridSize){
+    std::string obj;
+    obj.reserve(static_cast<size_t>(gridSize) * gridSize * 120);
+    char line[256];
+
+    obj += "# generated by obj_parse_bench\n";
+    for(int y = 0; y < gridSize; y++){
+        for(int x = 0; x < gridSize; x++){
+            float fx = x / float(gridSize), fy = y / float(gridSize);
+            snprintf(line, sizeof(line), "v %f %f %f\nvt %f %f\nvn 0.0 0.0 1.0\n", fx, fy, 0.1f * ((x * 7 + y * 13) % 17), fx, fy);
+            obj += line;
+        }
+    }
+
+    int groupRows = gridSize / 8 > 0 ? gridSize / 8 : 1;
+    for(int y = 0; y + 1 < gridSize; y++){
+        if(y % groupRows == 0){
+            snprintf(line, sizeof(line), "g part_%d\r\nusemtl material_%d\ns %s\n", y / groupRows, (y / groupRows) % 3, (y / groupRows) % 2 ? "off" : "1");
+            obj += line;
+        }
+        for(int x = 0; x + 1 < gridSize; x++){
+            int a = y * gridSize + x + 1;
+            int b = a + 1;
+            int c = a + gridSize + 1;
+            int d = a + gridSize;
+            snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d%s", a, a, a, b, b, b, c, c, c, d, d, d, x % 5 ? "\n" : "\r\n");
+            obj += line;
+        }
+    }
+
+    // a small trailing object that uses relative indices
+    obj += "o tail\nv 0 0 0\nv 1 0 0\nv 0 1 0\nvn 0 0 1\nf -3//-1 -2//-1 -1//-1\n";
+    return obj;
+}
+
+bool sameResult(const ObjResult& a, const ObjResult& b){
+    auto sameReals = [](const std::vector<tinyobj::real_t>& x, const std::vector<tinyobj::real_t>& y){
+        return x.size() == y.size() && (x.empty() || memcmp(x.data(), y.data(), x.size() * sizeof(x[0])) == 0);
+    };
+    auto sameIndices = [](const std::vector<tinyobj::index_t>& x, const std::vector<tinyobj::index_t>& y){
+        if(x.size() != y.size()){
+            return false;
+        }
+        for(size_t i = 0; i < x.size(); i++){
+            if(x[i].vertex_index != y[i].vertex_index || x[i].normal_index != y[i].normal_index || x[i].texcoord_index != y[i].texcoord_index){
+                return false;
+            }
+        }
+        return true;
+    };
+
+    if(a.ok != b.ok || a.warn != b.warn || a.err != b.err || a.materials.size() != b.materials.size()){
+        return false;
+    }
+    if(!sameReals(a.attrib.vertices, b.attrib.vertices) || !sameReals(a.attrib.normals, b.attrib.normals) ||
+       !sameReals(a.attrib.texcoords, b.attrib.texcoords) || !sameReals(a.attrib.colors, b.attrib.colors)){
+        return false;
+    }
+    if(a.shapes.size() != b.shapes.size()){
+        return false;
+    }
+    for(size_t i = 0; i < a.shapes.size(); i++){
+        const auto& sa = a.shapes[i];
+        const auto& sb = b.shapes[i];
+        if(sa.name != sb.name || !sameIndices(sa.mesh.indices, sb.mesh.indices) ||
+           sa.mesh.num_face_vertices != sb.mesh.num_face_vertices || sa.mesh.material_ids != sb.mesh.material_ids ||
+           sa.mesh.smoothing_group_ids != sb.mesh.smoothing_group_ids ||
+           !sameIndices(sa.lines.indices, sb.lines.indices) || !sameIndices(sa.points.indices, sb.points.indices)){
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename Fn>
+double bestOfThree(Fn fn){
+    double best = 1e30;
+    for(int i = 0; i < 3; i++){
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        best = ms < best ? ms : best;
+    }
+    return best;
+}
+
+int main(int argc, char** argv){
+    int gridSize = argc > 1 ? atoi(argv[1]) : 700;
+    const char* path = "obj_parse_bench.obj";
+
+    std::string obj = generateObj(gridSize);
+    std::ofstream(path, std::ios::binary).write(obj.data(), static_cast<std::streamsize>(obj.size()));
+    printf("%s: %.1f MB, %d x %d grid\n", path, obj.size() / (1024.0 * 1024.0), gridSize, gridSize);
+
+    ObjResult serial;
+    double serialMs = bestOfThree([&]{
+        serial = ObjResult{};
+        serial.ok = tinyobj::LoadObj(&serial.attrib, &serial.shapes, &serial.materials, &serial.warn, &serial.err, path);
+    });
+    printf("%-12s %9.1f ms\n", "serial", serialMs);
+
+    bool identical = true;
+    // at least 4 so the chunk merging gets exercised on small machines too
+    unsigned int maxThreads = std::max(4u, std::thread::hardware_concurrency());
+    for(unsigned int threads = 1; threads <= maxThreads; threads *= 2){
+        ObjResult parallel;
+        double parallelMs = bestOfThree([&]{
+            parallel = ObjResult{};
+            parallel.ok = tinyobj::LoadObjParallel(&parallel.attrib, &parallel.shapes, &parallel.materials, &parallel.warn, &parallel.err, path, NULL, true, true, threads);
+        });
+        bool same = sameResult(serial, parallel);
+        identical = identical && same;
+        printf("%2u threads   %9.1f ms  %5.2fx  %s\n", threads, parallelMs, serialMs / parallelMs, same ? "identical" : "MISMATCH");
+    }
+
+    remove(path);
+    return identical ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vulkan/vulkan_core.h>
+
+// Linear allocator over one persistently mapped buffer, split into one region per frame in flight.
+// Allocations are aligned sub ranges consumed through dynamic offset descriptors, they stay valid
+// until the same frame index comes around again and beginFrame() is called after its fence signaled.
+class FrameAllocator{
+public:
+    struct Allocation{
+        void* data;         // host pointer into the mapping, memory is coherent so no flush needed
+        uint32_t offset;    // absolute offset in the buffer, pass as the dynamic offset
+    };
+
+    // regionSize is rounded up to `alignment`, the memory has to hold regionSize * frameCount bytes
+    static VkDeviceSize getBufferSize(VkDeviceSize regionSize, uint32_t frameCount, VkDeviceSize alignment){
+        return alignUp(regionSize, alignment) * frameCount;
+    }
+
+    // memory has to be host visible and coherent, it stays mapped until destroy()
+    void init(VkDevice device, VkDeviceMemory memory, VkDeviceSize regionSize, uint32_t frameCount, VkDeviceSize alignment){
+        this->device = device;
+        this->memory = memory;
+        this->alignment = alignment;
+        this->regionSize = alignUp(regionSize, alignment);
+        this->frameCount = frameCount;
+
+        void* data;
+        if(vkMapMemory(device, memory, 0, this->regionSize * frameCount, 0, &data) != VK_SUCCESS){
+            throw std::runtime_error("failed to map frame allocator memory!");
+        }
+        mapped = static_cast<uint8_t*>(data);
+        beginFrame(0);
+    }
+
+    void destroy(){
+        if(mapped != nullptr){
+            vkUnmapMemory(device, memory);
+            mapped = nullptr;
+        }
+    }
+
+    // everything handed out for `frame` last time around is reused, only call once its fence signaled
+    void beginFrame(uint32_t frame){
+        regionBegin = regionSize * (frame % frameCount);
+        head = regionBegin;
+    }
+
+    Allocation allocate(VkDeviceSize size){
+        VkDeviceSize offset = alignUp(head, alignment);
+        if(offset + size > regionBegin + regionSize){
+            throw std::runtime_error("frame allocator out of memory!");
+        }
+        head = offset + size;
+        return {mapped + offset, static_cast<uint32_t>(offset)};
+    }
+
+    template<typename T>
+    Allocation push(const T& value){
+        Allocation allocation = allocate(sizeof(T));
+        memcpy(allocation.data, &value, sizeof(T));
+        return allocation;
+    }
+
+    // bytes used in the current frame, including alignment padding
+    VkDeviceSize getUsed() const { return head - regionBegin; }
+
+private:
+    static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment){
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    uint8_t* mapped = nullptr;
+    VkDeviceSize alignment = 1;
+    VkDeviceSize regionSize = 0;
+    uint32_t frameCount = 1;
+    VkDeviceSize regionBegin = 0;
+    VkDeviceSize head = 0;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 64-bit multiply-mix hash in the style of wyhash, 16 bytes per round
+namespace hash {
+
+    inline uint64_t mix(uint64_t a, uint64_t b){
+        __uint128_t r = static_cast<__uint128_t>(a) * b;
+        return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+    }
+
+    inline uint64_t read64(const uint8_t* p){
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline uint64_t hashBytes(const void* data, size_t length, uint64_t seed = 0){
+        constexpr uint64_t secret0 = 0xa0761d6478bd642full;
+        constexpr uint64_t secret1 = 0xe7037ed1a0b428dbull;
+        constexpr uint64_t secret2 = 0x8ebc6af09c88c6e3ull;
+
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        size_t remaining = length;
+        seed ^= mix(seed ^ secret0, secret1);
+
+        // two independent lanes so the multiplies can overlap
+        uint64_t seed2 = seed;
+        while(remaining >= 32){
+            seed = mix(read64(p) ^ secret1, read64(p + 8) ^ seed);
+            seed2 = mix(read64(p + 16) ^ secret2, read64(p + 24) ^ seed2);
+            p += 32;
+            remaining -= 32;
+        }
+        seed ^= seed2;
+        if(remaining >= 16){
+            seed = mix(read64(p) ^ secret1, read64(p + 8) ^ seed);
+            p += 16;
+            remaining -= 16;
+        }
+
+        // zero padded tail
+        uint8_t tail[16] = {};
+        memcpy(tail, p, remaining);
+        uint64_t a = read64(tail);
+        uint64_t b = read64(tail + 8);
+
+        return mix(secret1 ^ length, mix(a ^ secret1, b ^ seed));
+    }
+
+}
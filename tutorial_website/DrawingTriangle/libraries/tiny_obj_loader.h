@@ -626,6 +626,30 @@ bool LoadObj(attrib_t *attrib, std::vector<shape_t> *shapes,
              MaterialReader *readMatFn = NULL, bool triangulate = true,
              bool default_vcols_fallback = true);
 
+#if __cplusplus > 199711L
+/// Same as LoadObj(), but parses v/vn/vt/f records on `num_threads` threads.
+/// The file is read into memory and split into line aligned chunks.
+/// Output is identical to the serial loader.
+/// `num_threads` = 0 uses std::thread::hardware_concurrency().
+bool LoadObjParallel(attrib_t *attrib, std::vector<shape_t> *shapes,
+                     std::vector<material_t> *materials, std::string *warn,
+                     std::string *err, const char *filename,
+                     const char *mtl_basedir = NULL, bool triangulate = true,
+                     bool default_vcols_fallback = true,
+                     unsigned int num_threads = 0);
+
+/// Parallel parse of an in-memory .obj text of `buf_len` bytes.
+bool LoadObjParallelFromMemory(attrib_t *attrib,
+                               std::vector<shape_t> *shapes,
+                               std::vector<material_t> *materials,
+                               std::string *warn, std::string *err,
+                               const char *buf, size_t buf_len,
+                               MaterialReader *readMatFn = NULL,
+                               bool triangulate = true,
+                               bool default_vcols_fallback = true,
+                               unsigned int num_threads = 0);
+#endif
+
 /// Loads materials into std::map
 void LoadMtl(std::map<std::string, int> *material_map,
              std::vector<material_t> *materials, std::istream *inStream,
@@ -661,6 +685,12 @@ bool ParseTextureNameAndOption(std::string *texname, texture_option_t *texopt,
 #include <sstream>
 #include <utility>
 
+#if __cplusplus > 199711L
+#include <algorithm>
+#include <iterator>
+#include <thread>
+#endif
+
 #ifdef TINYOBJLOADER_USE_MAPBOX_EARCUT
 
 #ifdef TINYOBJLOADER_DONOT_INCLUDE_MAPBOX_EARCUT
@@ -2429,13 +2459,8 @@ bool LoadObj(attrib_t *attrib, std::vector<shape_t> *shapes,
                  triangulate, default_vcols_fallback);
 }
 
-bool LoadObj(attrib_t *attrib, std::vector<shape_t> *shapes,
-             std::vector<material_t> *materials, std::string *warn,
-             std::string *err, std::istream *inStream,
-             MaterialReader *readMatFn /*= NULL*/, bool triangulate,
-             bool default_vcols_fallback) {
-  std::stringstream errss;
-
+// Parser state shared by the serial and the parallel .obj loaders.
+struct ObjParseState {
   std::vector<real_t> v;
   std::vector<real_t> vn;
   std::vector<real_t> vt;
@@ -2448,496 +2473,553 @@ bool LoadObj(attrib_t *attrib, std::vector<shape_t> *shapes,
   // material
   std::set<std::string> material_filenames;
   std::map<std::string, int> material_map;
-  int material = -1;
+  int material;
 
   // smoothing group id
-  unsigned int current_smoothing_id =
-      0;  // Initial value. 0 means no smoothing.
+  unsigned int current_smoothing_id;
 
-  int greatest_v_idx = -1;
-  int greatest_vn_idx = -1;
-  int greatest_vt_idx = -1;
+  int greatest_v_idx;
+  int greatest_vn_idx;
+  int greatest_vt_idx;
 
   shape_t shape;
 
-  bool found_all_colors = true;
-
-  size_t line_num = 0;
-  std::string linebuf;
-  while (inStream->peek() != -1) {
-    safeGetline(*inStream, linebuf);
-
-    line_num++;
-
-    // Trim newline '\r\n' or '\n'
-    if (linebuf.size() > 0) {
-      if (linebuf[linebuf.size() - 1] == '\n')
-        linebuf.erase(linebuf.size() - 1);
-    }
-    if (linebuf.size() > 0) {
-      if (linebuf[linebuf.size() - 1] == '\r')
-        linebuf.erase(linebuf.size() - 1);
-    }
+  bool found_all_colors;
+
+  // Number of v/vn/vt records before the current line. Relative indices are
+  // resolved against these.
+  int num_v;
+  int num_vn;
+  int num_vt;
+
+  std::vector<shape_t> *shapes;
+  std::vector<material_t> *materials;
+  std::string *warn;
+  std::string *err;
+  MaterialReader *readMatFn;
+  bool triangulate;
+  bool default_vcols_fallback;
+
+  ObjParseState(std::vector<shape_t> *shapes_,
+                std::vector<material_t> *materials_, std::string *warn_,
+                std::string *err_, MaterialReader *readMatFn_,
+                bool triangulate_, bool default_vcols_fallback_)
+      : material(-1),
+        current_smoothing_id(0),  // Initial value. 0 means no smoothing.
+        greatest_v_idx(-1),
+        greatest_vn_idx(-1),
+        greatest_vt_idx(-1),
+        found_all_colors(true),
+        num_v(0),
+        num_vn(0),
+        num_vt(0),
+        shapes(shapes_),
+        materials(materials_),
+        warn(warn_),
+        err(err_),
+        readMatFn(readMatFn_),
+        triangulate(triangulate_),
+        default_vcols_fallback(default_vcols_fallback_) {}
+};
 
-    // Skip if empty line.
-    if (linebuf.empty()) {
-      continue;
+// Parses one non-empty, non-comment line. `token` points past the leading
+// whitespace. Returns false on a parse error(message is appended to `err`).
+static bool parseObjLine(ObjParseState *st, const char *token,
+                         size_t line_num) {
+  std::vector<real_t> &v = st->v;
+  std::vector<real_t> &vn = st->vn;
+  std::vector<real_t> &vt = st->vt;
+  std::vector<real_t> &vc = st->vc;
+  std::vector<skin_weight_t> &vw = st->vw;
+  std::vector<tag_t> &tags = st->tags;
+  PrimGroup &prim_group = st->prim_group;
+  std::string &name = st->name;
+  std::set<std::string> &material_filenames = st->material_filenames;
+  std::map<std::string, int> &material_map = st->material_map;
+  int &material = st->material;
+  unsigned int &current_smoothing_id = st->current_smoothing_id;
+  int &greatest_v_idx = st->greatest_v_idx;
+  int &greatest_vn_idx = st->greatest_vn_idx;
+  int &greatest_vt_idx = st->greatest_vt_idx;
+  shape_t &shape = st->shape;
+  bool &found_all_colors = st->found_all_colors;
+  std::vector<shape_t> *shapes = st->shapes;
+  std::vector<material_t> *materials = st->materials;
+  std::string *warn = st->warn;
+  std::string *err = st->err;
+  MaterialReader *readMatFn = st->readMatFn;
+  const bool triangulate = st->triangulate;
+  const bool default_vcols_fallback = st->default_vcols_fallback;
+  // vertex
+  if (token[0] == 'v' && IS_SPACE((token[1]))) {
+    token += 2;
+    real_t x, y, z;
+    real_t r, g, b;
+
+    found_all_colors &= parseVertexWithColor(&x, &y, &z, &r, &g, &b, &token);
+
+    v.push_back(x);
+    v.push_back(y);
+    v.push_back(z);
+
+    if (found_all_colors || default_vcols_fallback) {
+      vc.push_back(r);
+      vc.push_back(g);
+      vc.push_back(b);
     }
 
-    // Skip leading space.
-    const char *token = linebuf.c_str();
-    token += strspn(token, " \t");
-
-    assert(token);
-    if (token[0] == '\0') continue;  // empty line
-
-    if (token[0] == '#') continue;  // comment line
-
-    // vertex
-    if (token[0] == 'v' && IS_SPACE((token[1]))) {
-      token += 2;
-      real_t x, y, z;
-      real_t r, g, b;
-
-      found_all_colors &= parseVertexWithColor(&x, &y, &z, &r, &g, &b, &token);
-
-      v.push_back(x);
-      v.push_back(y);
-      v.push_back(z);
-
-      if (found_all_colors || default_vcols_fallback) {
-        vc.push_back(r);
-        vc.push_back(g);
-        vc.push_back(b);
-      }
+    return true;
+  }
 
-      continue;
-    }
+  // normal
+  if (token[0] == 'v' && token[1] == 'n' && IS_SPACE((token[2]))) {
+    token += 3;
+    real_t x, y, z;
+    parseReal3(&x, &y, &z, &token);
+    vn.push_back(x);
+    vn.push_back(y);
+    vn.push_back(z);
+    return true;
+  }
 
-    // normal
-    if (token[0] == 'v' && token[1] == 'n' && IS_SPACE((token[2]))) {
-      token += 3;
-      real_t x, y, z;
-      parseReal3(&x, &y, &z, &token);
-      vn.push_back(x);
-      vn.push_back(y);
-      vn.push_back(z);
-      continue;
-    }
+  // texcoord
+  if (token[0] == 'v' && token[1] == 't' && IS_SPACE((token[2]))) {
+    token += 3;
+    real_t x, y;
+    parseReal2(&x, &y, &token);
+    vt.push_back(x);
+    vt.push_back(y);
+    return true;
+  }
 
-    // texcoord
-    if (token[0] == 'v' && token[1] == 't' && IS_SPACE((token[2]))) {
-      token += 3;
-      real_t x, y;
-      parseReal2(&x, &y, &token);
-      vt.push_back(x);
-      vt.push_back(y);
-      continue;
-    }
+  // skin weight. tinyobj extension
+  if (token[0] == 'v' && token[1] == 'w' && IS_SPACE((token[2]))) {
+    token += 3;
 
-    // skin weight. tinyobj extension
-    if (token[0] == 'v' && token[1] == 'w' && IS_SPACE((token[2]))) {
-      token += 3;
+    // vw <vid> <joint_0> <weight_0> <joint_1> <weight_1> ...
+    // example:
+    // vw 0 0 0.25 1 0.25 2 0.5
 
-      // vw <vid> <joint_0> <weight_0> <joint_1> <weight_1> ...
-      // example:
-      // vw 0 0 0.25 1 0.25 2 0.5
+    // TODO(syoyo): Add syntax check
+    int vid = 0;
+    vid = parseInt(&token);
 
-      // TODO(syoyo): Add syntax check
-      int vid = 0;
-      vid = parseInt(&token);
+    skin_weight_t sw;
 
-      skin_weight_t sw;
+    sw.vertex_id = vid;
 
-      sw.vertex_id = vid;
+    while (!IS_NEW_LINE(token[0])) {
+      real_t j, w;
+      // joint_id should not be negative, weight may be negative
+      // TODO(syoyo): # of elements check
+      parseReal2(&j, &w, &token, -1.0);
 
-      while (!IS_NEW_LINE(token[0])) {
-        real_t j, w;
-        // joint_id should not be negative, weight may be negative
-        // TODO(syoyo): # of elements check
-        parseReal2(&j, &w, &token, -1.0);
-
-        if (j < static_cast<real_t>(0)) {
-          if (err) {
-            std::stringstream ss;
-            ss << "Failed parse `vw' line. joint_id is negative. "
-                  "line "
-               << line_num << ".)\n";
-            (*err) += ss.str();
-          }
-          return false;
+      if (j < static_cast<real_t>(0)) {
+        if (err) {
+          std::stringstream ss;
+          ss << "Failed parse `vw' line. joint_id is negative. "
+                "line "
+             << line_num << ".)\n";
+          (*err) += ss.str();
         }
+        return false;
+      }
 
-        joint_and_weight_t jw;
-
-        jw.joint_id = int(j);
-        jw.weight = w;
+      joint_and_weight_t jw;
 
-        sw.weightValues.push_back(jw);
+      jw.joint_id = int(j);
+      jw.weight = w;
 
-        size_t n = strspn(token, " \t\r");
-        token += n;
-      }
+      sw.weightValues.push_back(jw);
 
-      vw.push_back(sw);
+      size_t n = strspn(token, " \t\r");
+      token += n;
     }
 
-    // line
-    if (token[0] == 'l' && IS_SPACE((token[1]))) {
-      token += 2;
-
-      __line_t line;
+    vw.push_back(sw);
+  }
 
-      while (!IS_NEW_LINE(token[0])) {
-        vertex_index_t vi;
-        if (!parseTriple(&token, static_cast<int>(v.size() / 3),
-                         static_cast<int>(vn.size() / 3),
-                         static_cast<int>(vt.size() / 2), &vi)) {
-          if (err) {
-            std::stringstream ss;
-            ss << "Failed parse `l' line(e.g. zero value for vertex index. "
-                  "line "
-               << line_num << ".)\n";
-            (*err) += ss.str();
-          }
-          return false;
-        }
+  // line
+  if (token[0] == 'l' && IS_SPACE((token[1]))) {
+    token += 2;
 
-        line.vertex_indices.push_back(vi);
+    __line_t line;
 
-        size_t n = strspn(token, " \t\r");
-        token += n;
+    while (!IS_NEW_LINE(token[0])) {
+      vertex_index_t vi;
+      if (!parseTriple(&token, st->num_v,
+                       st->num_vn,
+                       st->num_vt, &vi)) {
+        if (err) {
+          std::stringstream ss;
+          ss << "Failed parse `l' line(e.g. zero value for vertex index. "
+                "line "
+             << line_num << ".)\n";
+          (*err) += ss.str();
+        }
+        return false;
       }
 
-      prim_group.lineGroup.push_back(line);
+      line.vertex_indices.push_back(vi);
 
-      continue;
+      size_t n = strspn(token, " \t\r");
+      token += n;
     }
 
-    // points
-    if (token[0] == 'p' && IS_SPACE((token[1]))) {
-      token += 2;
+    prim_group.lineGroup.push_back(line);
 
-      __points_t pts;
+    return true;
+  }
 
-      while (!IS_NEW_LINE(token[0])) {
-        vertex_index_t vi;
-        if (!parseTriple(&token, static_cast<int>(v.size() / 3),
-                         static_cast<int>(vn.size() / 3),
-                         static_cast<int>(vt.size() / 2), &vi)) {
-          if (err) {
-            std::stringstream ss;
-            ss << "Failed parse `p' line(e.g. zero value for vertex index. "
-                  "line "
-               << line_num << ".)\n";
-            (*err) += ss.str();
-          }
-          return false;
-        }
+  // points
+  if (token[0] == 'p' && IS_SPACE((token[1]))) {
+    token += 2;
 
-        pts.vertex_indices.push_back(vi);
+    __points_t pts;
 
-        size_t n = strspn(token, " \t\r");
-        token += n;
+    while (!IS_NEW_LINE(token[0])) {
+      vertex_index_t vi;
+      if (!parseTriple(&token, st->num_v,
+                       st->num_vn,
+                       st->num_vt, &vi)) {
+        if (err) {
+          std::stringstream ss;
+          ss << "Failed parse `p' line(e.g. zero value for vertex index. "
+                "line "
+             << line_num << ".)\n";
+          (*err) += ss.str();
+        }
+        return false;
       }
 
-      prim_group.pointsGroup.push_back(pts);
+      pts.vertex_indices.push_back(vi);
 
-      continue;
+      size_t n = strspn(token, " \t\r");
+      token += n;
     }
 
-    // face
-    if (token[0] == 'f' && IS_SPACE((token[1]))) {
-      token += 2;
-      token += strspn(token, " \t");
+    prim_group.pointsGroup.push_back(pts);
 
-      face_t face;
+    return true;
+  }
 
-      face.smoothing_group_id = current_smoothing_id;
-      face.vertex_indices.reserve(3);
+  // face
+  if (token[0] == 'f' && IS_SPACE((token[1]))) {
+    token += 2;
+    token += strspn(token, " \t");
 
-      while (!IS_NEW_LINE(token[0])) {
-        vertex_index_t vi;
-        if (!parseTriple(&token, static_cast<int>(v.size() / 3),
-                         static_cast<int>(vn.size() / 3),
-                         static_cast<int>(vt.size() / 2), &vi)) {
-          if (err) {
-            std::stringstream ss;
-            ss << "Failed parse `f' line(e.g. zero value for face index. line "
-               << line_num << ".)\n";
-            (*err) += ss.str();
-          }
-          return false;
-        }
+    face_t face;
 
-        greatest_v_idx = greatest_v_idx > vi.v_idx ? greatest_v_idx : vi.v_idx;
-        greatest_vn_idx =
-            greatest_vn_idx > vi.vn_idx ? greatest_vn_idx : vi.vn_idx;
-        greatest_vt_idx =
-            greatest_vt_idx > vi.vt_idx ? greatest_vt_idx : vi.vt_idx;
+    face.smoothing_group_id = current_smoothing_id;
+    face.vertex_indices.reserve(3);
 
-        face.vertex_indices.push_back(vi);
-        size_t n = strspn(token, " \t\r");
-        token += n;
+    while (!IS_NEW_LINE(token[0])) {
+      vertex_index_t vi;
+      if (!parseTriple(&token, st->num_v,
+                       st->num_vn,
+                       st->num_vt, &vi)) {
+        if (err) {
+          std::stringstream ss;
+          ss << "Failed parse `f' line(e.g. zero value for face index. line "
+             << line_num << ".)\n";
+          (*err) += ss.str();
+        }
+        return false;
       }
 
-      // replace with emplace_back + std::move on C++11
-      prim_group.faceGroup.push_back(face);
+      greatest_v_idx = greatest_v_idx > vi.v_idx ? greatest_v_idx : vi.v_idx;
+      greatest_vn_idx =
+          greatest_vn_idx > vi.vn_idx ? greatest_vn_idx : vi.vn_idx;
+      greatest_vt_idx =
+          greatest_vt_idx > vi.vt_idx ? greatest_vt_idx : vi.vt_idx;
 
-      continue;
+      face.vertex_indices.push_back(vi);
+      size_t n = strspn(token, " \t\r");
+      token += n;
     }
 
-    // use mtl
-    if ((0 == strncmp(token, "usemtl", 6))) {
-      token += 6;
-      std::string namebuf = parseString(&token);
+    // replace with emplace_back + std::move on C++11
+    prim_group.faceGroup.push_back(face);
 
-      int newMaterialId = -1;
-      std::map<std::string, int>::const_iterator it =
-          material_map.find(namebuf);
-      if (it != material_map.end()) {
-        newMaterialId = it->second;
-      } else {
-        // { error!! material not found }
-        if (warn) {
-          (*warn) += "material [ '" + namebuf + "' ] not found in .mtl\n";
-        }
-      }
+    return true;
+  }
+
+  // use mtl
+  if ((0 == strncmp(token, "usemtl", 6))) {
+    token += 6;
+    std::string namebuf = parseString(&token);
 
-      if (newMaterialId != material) {
-        // Create per-face material. Thus we don't add `shape` to `shapes` at
-        // this time.
-        // just clear `faceGroup` after `exportGroupsToShape()` call.
-        exportGroupsToShape(&shape, prim_group, tags, material, name,
-                            triangulate, v, warn);
-        prim_group.faceGroup.clear();
-        material = newMaterialId;
+    int newMaterialId = -1;
+    std::map<std::string, int>::const_iterator it =
+        material_map.find(namebuf);
+    if (it != material_map.end()) {
+      newMaterialId = it->second;
+    } else {
+      // { error!! material not found }
+      if (warn) {
+        (*warn) += "material [ '" + namebuf + "' ] not found in .mtl\n";
       }
+    }
 
-      continue;
+    if (newMaterialId != material) {
+      // Create per-face material. Thus we don't add `shape` to `shapes` at
+      // this time.
+      // just clear `faceGroup` after `exportGroupsToShape()` call.
+      exportGroupsToShape(&shape, prim_group, tags, material, name,
+                          triangulate, v, warn);
+      prim_group.faceGroup.clear();
+      material = newMaterialId;
     }
 
-    // load mtl
-    if ((0 == strncmp(token, "mtllib", 6)) && IS_SPACE((token[6]))) {
-      if (readMatFn) {
-        token += 7;
+    return true;
+  }
 
-        std::vector<std::string> filenames;
-        SplitString(std::string(token), ' ', '\\', filenames);
+  // load mtl
+  if ((0 == strncmp(token, "mtllib", 6)) && IS_SPACE((token[6]))) {
+    if (readMatFn) {
+      token += 7;
 
-        if (filenames.empty()) {
-          if (warn) {
-            std::stringstream ss;
-            ss << "Looks like empty filename for mtllib. Use default "
-                  "material (line "
-               << line_num << ".)\n";
+      std::vector<std::string> filenames;
+      SplitString(std::string(token), ' ', '\\', filenames);
+
+      if (filenames.empty()) {
+        if (warn) {
+          std::stringstream ss;
+          ss << "Looks like empty filename for mtllib. Use default "
+                "material (line "
+             << line_num << ".)\n";
 
-            (*warn) += ss.str();
+          (*warn) += ss.str();
+        }
+      } else {
+        bool found = false;
+        for (size_t s = 0; s < filenames.size(); s++) {
+          if (material_filenames.count(filenames[s]) > 0) {
+            found = true;
+            continue;
           }
-        } else {
-          bool found = false;
-          for (size_t s = 0; s < filenames.size(); s++) {
-            if (material_filenames.count(filenames[s]) > 0) {
-              found = true;
-              continue;
-            }
 
-            std::string warn_mtl;
-            std::string err_mtl;
-            bool ok = (*readMatFn)(filenames[s].c_str(), materials,
-                                   &material_map, &warn_mtl, &err_mtl);
-            if (warn && (!warn_mtl.empty())) {
-              (*warn) += warn_mtl;
-            }
+          std::string warn_mtl;
+          std::string err_mtl;
+          bool ok = (*readMatFn)(filenames[s].c_str(), materials,
+                                 &material_map, &warn_mtl, &err_mtl);
+          if (warn && (!warn_mtl.empty())) {
+            (*warn) += warn_mtl;
+          }
 
-            if (err && (!err_mtl.empty())) {
-              (*err) += err_mtl;
-            }
+          if (err && (!err_mtl.empty())) {
+            (*err) += err_mtl;
+          }
 
-            if (ok) {
-              found = true;
-              material_filenames.insert(filenames[s]);
-              break;
-            }
+          if (ok) {
+            found = true;
+            material_filenames.insert(filenames[s]);
+            break;
           }
+        }
 
-          if (!found) {
-            if (warn) {
-              (*warn) +=
-                  "Failed to load material file(s). Use default "
-                  "material.\n";
-            }
+        if (!found) {
+          if (warn) {
+            (*warn) +=
+                "Failed to load material file(s). Use default "
+                "material.\n";
           }
         }
       }
-
-      continue;
     }
 
-    // group name
-    if (token[0] == 'g' && IS_SPACE((token[1]))) {
-      // flush previous face group.
-      bool ret = exportGroupsToShape(&shape, prim_group, tags, material, name,
-                                     triangulate, v, warn);
-      (void)ret;  // return value not used.
+    return true;
+  }
 
-      if (shape.mesh.indices.size() > 0) {
-        shapes->push_back(shape);
-      }
+  // group name
+  if (token[0] == 'g' && IS_SPACE((token[1]))) {
+    // flush previous face group.
+    bool ret = exportGroupsToShape(&shape, prim_group, tags, material, name,
+                                   triangulate, v, warn);
+    (void)ret;  // return value not used.
 
-      shape = shape_t();
+    if (shape.mesh.indices.size() > 0) {
+      shapes->push_back(shape);
+    }
 
-      // material = -1;
-      prim_group.clear();
+    shape = shape_t();
 
-      std::vector<std::string> names;
+    // material = -1;
+    prim_group.clear();
 
-      while (!IS_NEW_LINE(token[0])) {
-        std::string str = parseString(&token);
-        names.push_back(str);
-        token += strspn(token, " \t\r");  // skip tag
-      }
+    std::vector<std::string> names;
 
-      // names[0] must be 'g'
+    while (!IS_NEW_LINE(token[0])) {
+      std::string str = parseString(&token);
+      names.push_back(str);
+      token += strspn(token, " \t\r");  // skip tag
+    }
 
-      if (names.size() < 2) {
-        // 'g' with empty names
-        if (warn) {
-          std::stringstream ss;
-          ss << "Empty group name. line: " << line_num << "\n";
-          (*warn) += ss.str();
-          name = "";
-        }
-      } else {
-        std::stringstream ss;
-        ss << names[1];
+    // names[0] must be 'g'
 
-        // tinyobjloader does not support multiple groups for a primitive.
-        // Currently we concatinate multiple group names with a space to get
-        // single group name.
+    if (names.size() < 2) {
+      // 'g' with empty names
+      if (warn) {
+        std::stringstream ss;
+        ss << "Empty group name. line: " << line_num << "\n";
+        (*warn) += ss.str();
+        name = "";
+      }
+    } else {
+      std::stringstream ss;
+      ss << names[1];
 
-        for (size_t i = 2; i < names.size(); i++) {
-          ss << " " << names[i];
-        }
+      // tinyobjloader does not support multiple groups for a primitive.
+      // Currently we concatinate multiple group names with a space to get
+      // single group name.
 
-        name = ss.str();
+      for (size_t i = 2; i < names.size(); i++) {
+        ss << " " << names[i];
       }
 
-      continue;
+      name = ss.str();
     }
 
-    // object name
-    if (token[0] == 'o' && IS_SPACE((token[1]))) {
-      // flush previous face group.
-      bool ret = exportGroupsToShape(&shape, prim_group, tags, material, name,
-                                     triangulate, v, warn);
-      (void)ret;  // return value not used.
-
-      if (shape.mesh.indices.size() > 0 || shape.lines.indices.size() > 0 ||
-          shape.points.indices.size() > 0) {
-        shapes->push_back(shape);
-      }
-
-      // material = -1;
-      prim_group.clear();
-      shape = shape_t();
+    return true;
+  }
 
-      // @todo { multiple object name? }
-      token += 2;
-      std::stringstream ss;
-      ss << token;
-      name = ss.str();
+  // object name
+  if (token[0] == 'o' && IS_SPACE((token[1]))) {
+    // flush previous face group.
+    bool ret = exportGroupsToShape(&shape, prim_group, tags, material, name,
+                                   triangulate, v, warn);
+    (void)ret;  // return value not used.
 
-      continue;
+    if (shape.mesh.indices.size() > 0 || shape.lines.indices.size() > 0 ||
+        shape.points.indices.size() > 0) {
+      shapes->push_back(shape);
     }
 
-    if (token[0] == 't' && IS_SPACE(token[1])) {
-      const int max_tag_nums = 8192;  // FIXME(syoyo): Parameterize.
-      tag_t tag;
+    // material = -1;
+    prim_group.clear();
+    shape = shape_t();
 
-      token += 2;
+    // @todo { multiple object name? }
+    token += 2;
+    std::stringstream ss;
+    ss << token;
+    name = ss.str();
 
-      tag.name = parseString(&token);
+    return true;
+  }
 
-      tag_sizes ts = parseTagTriple(&token);
+  if (token[0] == 't' && IS_SPACE(token[1])) {
+    const int max_tag_nums = 8192;  // FIXME(syoyo): Parameterize.
+    tag_t tag;
 
-      if (ts.num_ints < 0) {
-        ts.num_ints = 0;
-      }
-      if (ts.num_ints > max_tag_nums) {
-        ts.num_ints = max_tag_nums;
-      }
+    token += 2;
 
-      if (ts.num_reals < 0) {
-        ts.num_reals = 0;
-      }
-      if (ts.num_reals > max_tag_nums) {
-        ts.num_reals = max_tag_nums;
-      }
+    tag.name = parseString(&token);
 
-      if (ts.num_strings < 0) {
-        ts.num_strings = 0;
-      }
-      if (ts.num_strings > max_tag_nums) {
-        ts.num_strings = max_tag_nums;
-      }
+    tag_sizes ts = parseTagTriple(&token);
 
-      tag.intValues.resize(static_cast<size_t>(ts.num_ints));
+    if (ts.num_ints < 0) {
+      ts.num_ints = 0;
+    }
+    if (ts.num_ints > max_tag_nums) {
+      ts.num_ints = max_tag_nums;
+    }
 
-      for (size_t i = 0; i < static_cast<size_t>(ts.num_ints); ++i) {
-        tag.intValues[i] = parseInt(&token);
-      }
+    if (ts.num_reals < 0) {
+      ts.num_reals = 0;
+    }
+    if (ts.num_reals > max_tag_nums) {
+      ts.num_reals = max_tag_nums;
+    }
 
-      tag.floatValues.resize(static_cast<size_t>(ts.num_reals));
-      for (size_t i = 0; i < static_cast<size_t>(ts.num_reals); ++i) {
-        tag.floatValues[i] = parseReal(&token);
-      }
+    if (ts.num_strings < 0) {
+      ts.num_strings = 0;
+    }
+    if (ts.num_strings > max_tag_nums) {
+      ts.num_strings = max_tag_nums;
+    }
 
-      tag.stringValues.resize(static_cast<size_t>(ts.num_strings));
-      for (size_t i = 0; i < static_cast<size_t>(ts.num_strings); ++i) {
-        tag.stringValues[i] = parseString(&token);
-      }
+    tag.intValues.resize(static_cast<size_t>(ts.num_ints));
 
-      tags.push_back(tag);
+    for (size_t i = 0; i < static_cast<size_t>(ts.num_ints); ++i) {
+      tag.intValues[i] = parseInt(&token);
+    }
 
-      continue;
+    tag.floatValues.resize(static_cast<size_t>(ts.num_reals));
+    for (size_t i = 0; i < static_cast<size_t>(ts.num_reals); ++i) {
+      tag.floatValues[i] = parseReal(&token);
     }
 
-    if (token[0] == 's' && IS_SPACE(token[1])) {
-      // smoothing group id
-      token += 2;
+    tag.stringValues.resize(static_cast<size_t>(ts.num_strings));
+    for (size_t i = 0; i < static_cast<size_t>(ts.num_strings); ++i) {
+      tag.stringValues[i] = parseString(&token);
+    }
 
-      // skip space.
-      token += strspn(token, " \t");  // skip space
+    tags.push_back(tag);
 
-      if (token[0] == '\0') {
-        continue;
-      }
+    return true;
+  }
 
-      if (token[0] == '\r' || token[1] == '\n') {
-        continue;
-      }
+  if (token[0] == 's' && IS_SPACE(token[1])) {
+    // smoothing group id
+    token += 2;
+
+    // skip space.
+    token += strspn(token, " \t");  // skip space
+
+    if (token[0] == '\0') {
+      return true;
+    }
+
+    if (token[0] == '\r' || token[1] == '\n') {
+      return true;
+    }
 
-      if (strlen(token) >= 3 && token[0] == 'o' && token[1] == 'f' &&
-          token[2] == 'f') {
+    if (strlen(token) >= 3 && token[0] == 'o' && token[1] == 'f' &&
+        token[2] == 'f') {
+      current_smoothing_id = 0;
+    } else {
+      // assume number
+      int smGroupId = parseInt(&token);
+      if (smGroupId < 0) {
+        // parse error. force set to 0.
+        // FIXME(syoyo): Report warning.
         current_smoothing_id = 0;
       } else {
-        // assume number
-        int smGroupId = parseInt(&token);
-        if (smGroupId < 0) {
-          // parse error. force set to 0.
-          // FIXME(syoyo): Report warning.
-          current_smoothing_id = 0;
-        } else {
-          current_smoothing_id = static_cast<unsigned int>(smGroupId);
-        }
+        current_smoothing_id = static_cast<unsigned int>(smGroupId);
       }
+    }
 
-      continue;
-    }  // smoothing group id
+    return true;
+  }  // smoothing group id
 
-    // Ignore unknown command.
-  }
+  // Ignore unknown command.
+
+  return true;
+}
+
+// Flushes the last group and moves the parsed data into `attrib`.
+// `line_num` is the number of lines in the file.
+static bool finishObjParse(ObjParseState *st, attrib_t *attrib,
+                           size_t line_num) {
+  std::vector<real_t> &v = st->v;
+  std::vector<real_t> &vn = st->vn;
+  std::vector<real_t> &vt = st->vt;
+  std::vector<real_t> &vc = st->vc;
+  std::vector<skin_weight_t> &vw = st->vw;
+  std::vector<shape_t> *shapes = st->shapes;
+  std::string *warn = st->warn;
+  const bool default_vcols_fallback = st->default_vcols_fallback;
+  PrimGroup &prim_group = st->prim_group;
+  shape_t &shape = st->shape;
+  const int greatest_v_idx = st->greatest_v_idx;
+  const int greatest_vn_idx = st->greatest_vn_idx;
+  const int greatest_vt_idx = st->greatest_vt_idx;
+  const bool found_all_colors = st->found_all_colors;
+  const std::vector<tag_t> &tags = st->tags;
+  const int material = st->material;
+  const std::string &name = st->name;
+  const bool triangulate = st->triangulate;
 
   // not all vertices have colors, no default colors desired? -> clear colors
   if (!found_all_colors && !default_vcols_fallback) {
@@ -2978,10 +3060,6 @@ bool LoadObj(attrib_t *attrib, std::vector<shape_t> *shapes,
   }
   prim_group.clear();  // for safety
 
-  if (err) {
-    (*err) += errss.str();
-  }
-
   attrib->vertices.swap(v);
   attrib->vertex_weights.swap(v);
   attrib->normals.swap(vn);
@@ -2993,6 +3071,506 @@ bool LoadObj(attrib_t *attrib, std::vector<shape_t> *shapes,
   return true;
 }
 
+bool LoadObj(attrib_t *attrib, std::vector<shape_t> *shapes,
+             std::vector<material_t> *materials, std::string *warn,
+             std::string *err, std::istream *inStream,
+             MaterialReader *readMatFn /*= NULL*/, bool triangulate,
+             bool default_vcols_fallback) {
+  ObjParseState st(shapes, materials, warn, err, readMatFn, triangulate,
+                   default_vcols_fallback);
+
+  size_t line_num = 0;
+  std::string linebuf;
+  while (inStream->peek() != -1) {
+    safeGetline(*inStream, linebuf);
+
+    line_num++;
+
+    // Trim newline '\r\n' or '\n'
+    if (linebuf.size() > 0) {
+      if (linebuf[linebuf.size() - 1] == '\n')
+        linebuf.erase(linebuf.size() - 1);
+    }
+    if (linebuf.size() > 0) {
+      if (linebuf[linebuf.size() - 1] == '\r')
+        linebuf.erase(linebuf.size() - 1);
+    }
+
+    // Skip if empty line.
+    if (linebuf.empty()) {
+      continue;
+    }
+
+    // Skip leading space.
+    const char *token = linebuf.c_str();
+    token += strspn(token, " \t");
+
+    assert(token);
+    if (token[0] == '\0') continue;  // empty line
+
+    if (token[0] == '#') continue;  // comment line
+
+    st.num_v = static_cast<int>(st.v.size() / 3);
+    st.num_vn = static_cast<int>(st.vn.size() / 3);
+    st.num_vt = static_cast<int>(st.vt.size() / 2);
+    if (!parseObjLine(&st, token, line_num)) {
+      return false;
+    }
+  }
+
+  return finishObjParse(&st, attrib, line_num);
+}
+
+#if __cplusplus > 199711L
+// Parallel parser. The buffer is split into line aligned chunks. A first pass
+// counts lines and v/vn/vt records per chunk, so that the second pass can
+// resolve relative indices on the workers. v/vn/vt/f lines are parsed on the
+// workers, everything else(groups, materials, smoothing groups, ...) is kept
+// as text and replayed in file order through parseObjLine() when merging.
+
+enum ObjLineKind {
+  OBJ_LINE_SKIP,
+  OBJ_LINE_VERTEX,
+  OBJ_LINE_NORMAL,
+  OBJ_LINE_TEXCOORD,
+  OBJ_LINE_FACE,
+  OBJ_LINE_OTHER
+};
+
+// Same classification as the serial loop, bytes past `line_end` read as '\0'.
+static ObjLineKind classifyObjLine(const char *p, const char *line_end) {
+  while (p < line_end && (*p == ' ' || *p == '\t')) p++;
+  const char c0 = (p < line_end) ? p[0] : '\0';
+  const char c1 = (p + 1 < line_end) ? p[1] : '\0';
+  const char c2 = (p + 2 < line_end) ? p[2] : '\0';
+
+  if (c0 == '\0' || c0 == '#') return OBJ_LINE_SKIP;
+  if (c0 == 'v' && IS_SPACE(c1)) return OBJ_LINE_VERTEX;
+  if (c0 == 'v' && c1 == 'n' && IS_SPACE(c2)) return OBJ_LINE_NORMAL;
+  if (c0 == 'v' && c1 == 't' && IS_SPACE(c2)) return OBJ_LINE_TEXCOORD;
+  if (c0 == 'f' && IS_SPACE(c1)) return OBJ_LINE_FACE;
+  return OBJ_LINE_OTHER;
+}
+
+// Same line endings as safeGetline(): "\n", "\r\n" and "\r".
+// Returns the start of the next line.
+static const char *nextObjLine(const char *p, const char *end,
+                               const char **line_end) {
+  const char *q = p;
+  while (q < end && *q != '\n' && *q != '\r') q++;
+  *line_end = q;
+  if (q < end) {
+    if (q[0] == '\r' && q + 1 < end && q[1] == '\n') q++;
+    q++;
+  }
+  return q;
+}
+
+struct ObjRecord {
+  enum Kind { FACE, OTHER, FACE_ERROR };
+  Kind kind;
+  size_t line_num;
+  size_t first;  // FACE: first index in face_indices, OTHER: index in others
+  size_t count;  // FACE: number of vertices
+};
+
+struct ObjOtherLine {
+  std::string text;
+  int num_v, num_vn, num_vt;
+};
+
+struct ObjChunk {
+  const char *begin;
+  const char *end;
+
+  // first pass
+  size_t num_lines;
+  int num_v, num_vn, num_vt;
+
+  // second pass
+  std::vector<real_t> v, vn, vt, vc;
+  bool found_all_colors;
+  bool forward_reference;  // face uses a vertex defined later in the file
+  std::vector<vertex_index_t> face_indices;
+  std::vector<ObjRecord> records;
+  std::vector<ObjOtherLine> others;
+
+  ObjChunk()
+      : begin(NULL),
+        end(NULL),
+        num_lines(0),
+        num_v(0),
+        num_vn(0),
+        num_vt(0),
+        found_all_colors(true),
+        forward_reference(false) {}
+};
+
+// small chunks aren't worth a thread
+static const size_t kObjMinChunkSize = 1024 * 1024;
+
+static size_t countObjChunks(size_t buf_len, unsigned int num_threads) {
+  if (num_threads == 0) {
+    num_threads = std::thread::hardware_concurrency();
+  }
+  size_t num_chunks = std::min<size_t>(num_threads, buf_len / kObjMinChunkSize);
+  return num_chunks < 1 ? 1 : num_chunks;
+}
+
+// lets the serial loader read a buffer in place, std::istringstream would copy it
+class ObjMemoryStreamBuf : public std::streambuf {
+ public:
+  ObjMemoryStreamBuf(const char *buf, size_t buf_len) {
+    char *p = const_cast<char *>(buf);
+    setg(p, p, p + buf_len);
+  }
+};
+
+template <typename Fn>
+static void parallelForObjChunks(size_t count, Fn fn) {
+  std::vector<std::thread> workers;
+  workers.reserve(count);
+  for (size_t i = 1; i < count; i++) {
+    workers.push_back(std::thread(fn, i));
+  }
+  fn(0);
+  for (size_t i = 0; i < workers.size(); i++) {
+    workers[i].join();
+  }
+}
+
+static void countObjChunk(ObjChunk *chunk) {
+  const char *p = chunk->begin;
+  while (p < chunk->end) {
+    const char *line_end;
+    const char *next = nextObjLine(p, chunk->end, &line_end);
+    chunk->num_lines++;
+    switch (classifyObjLine(p, line_end)) {
+      case OBJ_LINE_VERTEX:
+        chunk->num_v++;
+        break;
+      case OBJ_LINE_NORMAL:
+        chunk->num_vn++;
+        break;
+      case OBJ_LINE_TEXCOORD:
+        chunk->num_vt++;
+        break;
+      default:
+        break;
+    }
+    p = next;
+  }
+}
+
+// `line_num`, `num_v`, ... are the totals of all preceding chunks.
+static void parseObjChunk(ObjChunk *chunk, size_t line_num, int num_v,
+                          int num_vn, int num_vt) {
+  chunk->v.reserve(3 * static_cast<size_t>(chunk->num_v));
+  chunk->vc.reserve(3 * static_cast<size_t>(chunk->num_v));
+  chunk->vn.reserve(3 * static_cast<size_t>(chunk->num_vn));
+  chunk->vt.reserve(2 * static_cast<size_t>(chunk->num_vt));
+
+  std::string linebuf;
+  const char *p = chunk->begin;
+  while (p < chunk->end) {
+    const char *line_end;
+    const char *next = nextObjLine(p, chunk->end, &line_end);
+    const ObjLineKind kind = classifyObjLine(p, line_end);
+    line_num++;
+
+    if (kind == OBJ_LINE_SKIP) {
+      p = next;
+      continue;
+    }
+
+    // parse from a NUL terminated copy, exactly like the serial loop does
+    linebuf.assign(p, line_end);
+    const char *token = linebuf.c_str();
+    token += strspn(token, " \t");
+    p = next;
+
+    if (kind == OBJ_LINE_VERTEX) {
+      token += 2;
+      real_t x, y, z;
+      real_t r, g, b;
+
+      chunk->found_all_colors &=
+          parseVertexWithColor(&x, &y, &z, &r, &g, &b, &token);
+
+      chunk->v.push_back(x);
+      chunk->v.push_back(y);
+      chunk->v.push_back(z);
+      // dropped after merging when colors are incomplete and not wanted
+      chunk->vc.push_back(r);
+      chunk->vc.push_back(g);
+      chunk->vc.push_back(b);
+      num_v++;
+      continue;
+    }
+
+    if (kind == OBJ_LINE_NORMAL) {
+      token += 3;
+      real_t x, y, z;
+      parseReal3(&x, &y, &z, &token);
+      chunk->vn.push_back(x);
+      chunk->vn.push_back(y);
+      chunk->vn.push_back(z);
+      num_vn++;
+      continue;
+    }
+
+    if (kind == OBJ_LINE_TEXCOORD) {
+      token += 3;
+      real_t x, y;
+      parseReal2(&x, &y, &token);
+      chunk->vt.push_back(x);
+      chunk->vt.push_back(y);
+      num_vt++;
+      continue;
+    }
+
+    ObjRecord record;
+    record.line_num = line_num;
+
+    if (kind == OBJ_LINE_OTHER) {
+      ObjOtherLine other;
+      other.text = token;
+      other.num_v = num_v;
+      other.num_vn = num_vn;
+      other.num_vt = num_vt;
+
+      record.kind = ObjRecord::OTHER;
+      record.first = chunk->others.size();
+      record.count = 0;
+      chunk->others.push_back(other);
+      chunk->records.push_back(record);
+      continue;
+    }
+
+    // face
+    token += 2;
+    token += strspn(token, " \t");
+
+    record.kind = ObjRecord::FACE;
+    record.first = chunk->face_indices.size();
+    record.count = 0;
+
+    while (!IS_NEW_LINE(token[0])) {
+      vertex_index_t vi;
+      if (!parseTriple(&token, num_v, num_vn, num_vt, &vi)) {
+        // the merge reports it, nothing after this line matters
+        record.kind = ObjRecord::FACE_ERROR;
+        chunk->records.push_back(record);
+        return;
+      }
+
+      // the serial loader triangulates against the vertices read so far
+      if (vi.v_idx >= num_v) {
+        chunk->forward_reference = true;
+        return;
+      }
+
+      chunk->face_indices.push_back(vi);
+      record.count++;
+      size_t n = strspn(token, " \t\r");
+      token += n;
+    }
+
+    chunk->records.push_back(record);
+  }
+}
+
+static bool mergeObjChunks(std::vector<ObjChunk> &chunks, attrib_t *attrib,
+                           ObjParseState *st) {
+  size_t total_v = 0, total_vn = 0, total_vt = 0;
+  for (size_t i = 0; i < chunks.size(); i++) {
+    total_v += chunks[i].v.size();
+    total_vn += chunks[i].vn.size();
+    total_vt += chunks[i].vt.size();
+  }
+  st->v.reserve(total_v);
+  st->vc.reserve(total_v);
+  st->vn.reserve(total_vn);
+  st->vt.reserve(total_vt);
+  for (size_t i = 0; i < chunks.size(); i++) {
+    st->v.insert(st->v.end(), chunks[i].v.begin(), chunks[i].v.end());
+    st->vc.insert(st->vc.end(), chunks[i].vc.begin(), chunks[i].vc.end());
+    st->vn.insert(st->vn.end(), chunks[i].vn.begin(), chunks[i].vn.end());
+    st->vt.insert(st->vt.end(), chunks[i].vt.begin(), chunks[i].vt.end());
+    st->found_all_colors &= chunks[i].found_all_colors;
+  }
+
+  size_t line_num = 0;
+  for (size_t i = 0; i < chunks.size(); i++) {
+    ObjChunk &chunk = chunks[i];
+    for (size_t r = 0; r < chunk.records.size(); r++) {
+      const ObjRecord &record = chunk.records[r];
+
+      if (record.kind == ObjRecord::FACE) {
+        face_t face;
+        face.smoothing_group_id = st->current_smoothing_id;
+        face.vertex_indices.assign(
+            chunk.face_indices.begin() + static_cast<std::ptrdiff_t>(record.first),
+            chunk.face_indices.begin() +
+                static_cast<std::ptrdiff_t>(record.first + record.count));
+
+        for (size_t k = 0; k < face.vertex_indices.size(); k++) {
+          const vertex_index_t &vi = face.vertex_indices[k];
+          st->greatest_v_idx =
+              st->greatest_v_idx > vi.v_idx ? st->greatest_v_idx : vi.v_idx;
+          st->greatest_vn_idx =
+              st->greatest_vn_idx > vi.vn_idx ? st->greatest_vn_idx : vi.vn_idx;
+          st->greatest_vt_idx =
+              st->greatest_vt_idx > vi.vt_idx ? st->greatest_vt_idx : vi.vt_idx;
+        }
+
+        st->prim_group.faceGroup.push_back(face);
+        continue;
+      }
+
+      if (record.kind == ObjRecord::FACE_ERROR) {
+        if (st->err) {
+          std::stringstream ss;
+          ss << "Failed parse `f' line(e.g. zero value for face index. line "
+             << record.line_num << ".)\n";
+          (*st->err) += ss.str();
+        }
+        return false;
+      }
+
+      const ObjOtherLine &other = chunk.others[record.first];
+      st->num_v = other.num_v;
+      st->num_vn = other.num_vn;
+      st->num_vt = other.num_vt;
+      if (!parseObjLine(st, other.text.c_str(), record.line_num)) {
+        return false;
+      }
+    }
+    line_num += chunk.num_lines;
+  }
+
+  return finishObjParse(st, attrib, line_num);
+}
+
+bool LoadObjParallelFromMemory(attrib_t *attrib,
+                               std::vector<shape_t> *shapes,
+                               std::vector<material_t> *materials,
+                               std::string *warn, std::string *err,
+                               const char *buf, size_t buf_len,
+                               MaterialReader *readMatFn, bool triangulate,
+                               bool default_vcols_fallback,
+                               unsigned int num_threads) {
+  size_t num_chunks = countObjChunks(buf_len, num_threads);
+  if (num_chunks == 1) {
+    // nothing to overlap, and the two pass chunk parse costs more than the serial loader
+    ObjMemoryStreamBuf streambuf(buf, buf_len);
+    std::istream is(&streambuf);
+    return LoadObj(attrib, shapes, materials, warn, err, &is, readMatFn,
+                   triangulate, default_vcols_fallback);
+  }
+
+  // chunks start right after a '\n', which always begins a new line
+  std::vector<ObjChunk> chunks(num_chunks);
+  const char *end = buf + buf_len;
+  const char *p = buf;
+  for (size_t i = 0; i < num_chunks; i++) {
+    const char *chunk_end = (i + 1 == num_chunks)
+                                ? end
+                                : buf + (buf_len / num_chunks) * (i + 1);
+    if (chunk_end < p) chunk_end = p;
+    while (chunk_end < end && chunk_end > p && chunk_end[-1] != '\n') {
+      chunk_end++;
+    }
+    chunks[i].begin = p;
+    chunks[i].end = chunk_end;
+    p = chunk_end;
+  }
+
+  parallelForObjChunks(num_chunks,
+                       [&](size_t i) { countObjChunk(&chunks[i]); });
+
+  std::vector<size_t> line_offsets(num_chunks);
+  std::vector<int> v_offsets(num_chunks), vn_offsets(num_chunks),
+      vt_offsets(num_chunks);
+  for (size_t i = 1; i < num_chunks; i++) {
+    line_offsets[i] = line_offsets[i - 1] + chunks[i - 1].num_lines;
+    v_offsets[i] = v_offsets[i - 1] + chunks[i - 1].num_v;
+    vn_offsets[i] = vn_offsets[i - 1] + chunks[i - 1].num_vn;
+    vt_offsets[i] = vt_offsets[i - 1] + chunks[i - 1].num_vt;
+  }
+
+  parallelForObjChunks(num_chunks, [&](size_t i) {
+    parseObjChunk(&chunks[i], line_offsets[i], v_offsets[i], vn_offsets[i],
+                  vt_offsets[i]);
+  });
+
+  bool forward_reference = false;
+  for (size_t i = 0; i < num_chunks; i++) {
+    forward_reference |= chunks[i].forward_reference;
+  }
+  if (forward_reference) {
+    // rare, and only the serial loader gets the triangulation of those right
+    ObjMemoryStreamBuf streambuf(buf, buf_len);
+    std::istream is(&streambuf);
+    return LoadObj(attrib, shapes, materials, warn, err, &is, readMatFn,
+                   triangulate, default_vcols_fallback);
+  }
+
+  ObjParseState st(shapes, materials, warn, err, readMatFn, triangulate,
+                   default_vcols_fallback);
+  return mergeObjChunks(chunks, attrib, &st);
+}
+
+bool LoadObjParallel(attrib_t *attrib, std::vector<shape_t> *shapes,
+                     std::vector<material_t> *materials, std::string *warn,
+                     std::string *err, const char *filename,
+                     const char *mtl_basedir, bool triangulate,
+                     bool default_vcols_fallback, unsigned int num_threads) {
+  attrib->vertices.clear();
+  attrib->normals.clear();
+  attrib->texcoords.clear();
+  attrib->colors.clear();
+  shapes->clear();
+
+  std::ifstream ifs(filename, std::ios::binary);
+  if (!ifs) {
+    if (err) {
+      std::stringstream errss;
+      errss << "Cannot open file [" << filename << "]\n";
+      (*err) = errss.str();
+    }
+    return false;
+  }
+  // files that make a single chunk go through the serial loader untouched
+  ifs.seekg(0, std::ios::end);
+  size_t file_size = static_cast<size_t>(ifs.tellg());
+  if (countObjChunks(file_size, num_threads) == 1) {
+    ifs.close();
+    return LoadObj(attrib, shapes, materials, warn, err, filename, mtl_basedir,
+                   triangulate, default_vcols_fallback);
+  }
+  ifs.seekg(0, std::ios::beg);
+  std::string buf((std::istreambuf_iterator<char>(ifs)),
+                  std::istreambuf_iterator<char>());
+
+  std::string baseDir = mtl_basedir ? mtl_basedir : "";
+  if (!baseDir.empty()) {
+#ifndef _WIN32
+    const char dirsep = '/';
+#else
+    const char dirsep = '\\';
+#endif
+    if (baseDir[baseDir.length() - 1] != dirsep) baseDir += dirsep;
+  }
+  MaterialFileReader matFileReader(baseDir);
+
+  return LoadObjParallelFromMemory(attrib, shapes, materials, warn, err,
+                                   buf.data(), buf.size(), &matFileReader,
+                                   triangulate, default_vcols_fallback,
+                                   num_threads);
+}
+#endif
+
 bool LoadObjWithCallback(std::istream &inStream, const callback_t &callback,
                          void *user_data /*= NULL*/,
                          MaterialReader *readMatFn /*= NULL*/,
@@ -27,16 +27,19 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include <chrono>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.hpp>
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
-#include <unordered_map>
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
 
 #include "ezprint.hpp"
+#include "frame_allocator.hpp"
+#include "mesh_cache.hpp"
+#include "mesh_optimizer.hpp"
+#include "vertex_weld.hpp"
 
 VkResult CreateDebugUtilsMessengerEXT(VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDebugUtilsMessengerEXT* pDebugMessenger) {
     auto func = (PFN_vkCreateDebugUtilsMessengerEXT) vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT");
@@ -110,23 +113,169 @@ struct Vertex{
     }
 };
 
-namespace std {
-    template <> struct hash<Vertex>{
-        size_t operator()(Vertex const& vertex) const{
-            return ((hash<glm::vec3>()(vertex.pos) ^
-                    (hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^ 
-                    (hash<glm::vec2>()(vertex.texCoord) << 1);
+enum class VertexLayout : uint32_t{
+    Float32,    // Vertex as loaded, 32 bytes
+    Half,       // PackedVertex with half float positions, 16 bytes
+    Snorm16,    // PackedVertex with 16 bit snorm positions, 16 bytes
+};
+
+// Compact vertex. Positions are mapped from the mesh bounds to [-1, 1] and decoded by the model matrix,
+// texture coordinates from their bounds to [0, 1] and decoded with UniformBufferObject::uvTransform.
+struct PackedVertex{
+    uint16_t pos[4];        // snorm16 or half, w is padding
+    uint8_t color[4];       // unorm8, a is padding
+    uint16_t texCoord[2];   // unorm16
+};
+
+uint32_t getVertexStride(VertexLayout layout){
+    return layout == VertexLayout::Float32 ? sizeof(Vertex) : sizeof(PackedVertex);
+}
+
+VkVertexInputBindingDescription getVertexBindingDescription(VertexLayout layout){
+    VkVertexInputBindingDescription bindingDescription = Vertex::getBindingDescripton();
+    bindingDescription.stride = getVertexStride(layout);
+    return bindingDescription;
+}
+
+// the shader reads floats either way, only the formats differ
+std::array<VkVertexInputAttributeDescription, 3> getVertexAttributeDescriptions(VertexLayout layout){
+    if(layout == VertexLayout::Float32){
+        return Vertex::getAttributeDescriptons();
+    }
+
+    std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
+
+    attributeDescriptions[0].binding = 0;
+    attributeDescriptions[0].location = 0;
+    attributeDescriptions[0].format = layout == VertexLayout::Half ? VK_FORMAT_R16G16B16A16_SFLOAT : VK_FORMAT_R16G16B16A16_SNORM;
+    attributeDescriptions[0].offset = offsetof(PackedVertex, pos);
+
+    attributeDescriptions[1].binding = 0;
+    attributeDescriptions[1].location = 1;
+    attributeDescriptions[1].format = VK_FORMAT_R8G8B8A8_UNORM;
+    attributeDescriptions[1].offset = offsetof(PackedVertex, color);
+
+    attributeDescriptions[2].binding = 0;
+    attributeDescriptions[2].location = 2;
+    attributeDescriptions[2].format = VK_FORMAT_R16G16_UNORM;
+    attributeDescriptions[2].offset = offsetof(PackedVertex, texCoord);
+
+    return attributeDescriptions;
+}
+
+MeshBounds computeMeshBounds(const std::vector<Vertex>& vertices){
+    MeshBounds bounds{};
+    if(vertices.empty()){
+        return bounds;
+    }
+
+    glm::vec3 minPos = vertices[0].pos, maxPos = vertices[0].pos;
+    glm::vec2 minUv = vertices[0].texCoord, maxUv = vertices[0].texCoord;
+    for(const auto& vertex : vertices){
+        minPos = glm::min(minPos, vertex.pos);
+        maxPos = glm::max(maxPos, vertex.pos);
+        minUv = glm::min(minUv, vertex.texCoord);
+        maxUv = glm::max(maxUv, vertex.texCoord);
+    }
+    memcpy(bounds.positionMin, &minPos, sizeof(bounds.positionMin));
+    memcpy(bounds.positionMax, &maxPos, sizeof(bounds.positionMax));
+    memcpy(bounds.texCoordMin, &minUv, sizeof(bounds.texCoordMin));
+    memcpy(bounds.texCoordMax, &maxUv, sizeof(bounds.texCoordMax));
+    return bounds;
+}
+
+// packed position -> model space, identity for Float32
+glm::mat4 getPositionDecode(VertexLayout layout, const MeshBounds& bounds){
+    if(layout == VertexLayout::Float32){
+        return glm::mat4(1.0f);
+    }
+    glm::vec3 minPos = glm::make_vec3(bounds.positionMin), maxPos = glm::make_vec3(bounds.positionMax);
+    // flat axes still need a non zero scale
+    glm::vec3 extent = glm::max((maxPos - minPos) * 0.5f, glm::vec3(1e-6f));
+    return glm::scale(glm::translate(glm::mat4(1.0f), (minPos + maxPos) * 0.5f), extent);
+}
+
+// packed uv -> uv as xy * scale + offset, stored as (scale, offset)
+glm::vec4 getTexCoordDecode(VertexLayout layout, const MeshBounds& bounds){
+    if(layout == VertexLayout::Float32){
+        return glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+    }
+    glm::vec2 minUv = glm::make_vec2(bounds.texCoordMin), maxUv = glm::make_vec2(bounds.texCoordMax);
+    return glm::vec4(glm::max(maxUv - minUv, glm::vec2(1e-6f)), minUv);
+}
+
+struct QuantizationError{
+    float maxPosition;      // model space units
+    float rmsPosition;
+    float maxColor;
+    float maxTexCoord;      // uv units
+};
+
+// encodes `vertices` into `layout` and measures the error of decoding them again
+QuantizationError encodeVertices(const std::vector<Vertex>& vertices, VertexLayout layout, const MeshBounds& bounds, std::vector<uint8_t>& out){
+    QuantizationError error{};
+    out.resize(vertices.size() * getVertexStride(layout));
+
+    if(layout == VertexLayout::Float32){
+        memcpy(out.data(), vertices.data(), out.size());
+        return error;
+    }
+
+    glm::mat4 positionDecode = getPositionDecode(layout, bounds);
+    glm::mat4 positionEncode = glm::inverse(positionDecode);
+    glm::vec4 uvDecode = getTexCoordDecode(layout, bounds);
+
+    double squaredPositionError = 0.0;
+    for(size_t i = 0; i < vertices.size(); i++){
+        const Vertex& vertex = vertices[i];
+        PackedVertex packed{};
+
+        glm::vec3 q = glm::clamp(glm::vec3(positionEncode * glm::vec4(vertex.pos, 1.0f)), -1.0f, 1.0f);
+        glm::vec3 decodedQ;
+        for(int k = 0; k < 3; k++){
+            if(layout == VertexLayout::Half){
+                packed.pos[k] = glm::packHalf1x16(q[k]);
+                decodedQ[k] = glm::unpackHalf1x16(packed.pos[k]);
+            }
+            else{
+                packed.pos[k] = glm::packSnorm1x16(q[k]);
+                decodedQ[k] = glm::unpackSnorm1x16(packed.pos[k]);
+            }
         }
-    };
+        glm::vec3 decodedPos = glm::vec3(positionDecode * glm::vec4(decodedQ, 1.0f));
+        float positionError = glm::distance(decodedPos, vertex.pos);
+        error.maxPosition = std::max(error.maxPosition, positionError);
+        squaredPositionError += double(positionError) * positionError;
+
+        for(int k = 0; k < 3; k++){
+            packed.color[k] = glm::packUnorm1x8(vertex.color[k]);
+            error.maxColor = std::max(error.maxColor, std::abs(glm::unpackUnorm1x8(packed.color[k]) - vertex.color[k]));
+        }
+        packed.color[3] = 255;
+
+        glm::vec2 t = glm::clamp((vertex.texCoord - glm::vec2(uvDecode.z, uvDecode.w)) / glm::vec2(uvDecode.x, uvDecode.y), 0.0f, 1.0f);
+        for(int k = 0; k < 2; k++){
+            packed.texCoord[k] = glm::packUnorm1x16(t[k]);
+            float decoded = glm::unpackUnorm1x16(packed.texCoord[k]) * uvDecode[k] + uvDecode[k + 2];
+            error.maxTexCoord = std::max(error.maxTexCoord, std::abs(decoded - vertex.texCoord[k]));
+        }
+
+        memcpy(out.data() + i * sizeof(PackedVertex), &packed, sizeof(PackedVertex));
+    }
+    error.rmsPosition = vertices.empty() ? 0.0f : float(std::sqrt(squaredPositionError / vertices.size()));
+    return error;
 }
 
 struct UniformBufferObject{
     glm::mat4 model;
     glm::mat4 view;
     glm::mat4 proj;
+    glm::vec4 uvTransform;  // xy scale, zw offset applied to the vertex uv
 };
 
 const int MAX_FRAMES_IN_FLIGHT = 2;
+// per frame budget for uniform data, handed out by the frame allocator
+const VkDeviceSize UNIFORM_FRAME_SIZE = 64 * 1024;
 
 class HelloTriangleApplication{
 public:
@@ -142,7 +291,10 @@ private:
     const uint32_t HEIGHT = 600;
     // asset paths
     const std::string MODEL_PATH = "models/viking_room.obj";
+    const std::string MODEL_CACHE_PATH = MODEL_PATH + ".meshcache";
     const std::string TEXTURE_PATH = "textures/viking_room.png";
+    // vertex format the model is uploaded in
+    const VertexLayout VERTEX_LAYOUT = VertexLayout::Snorm16;
 
     // validation layers
     const std::vector<const char*> validationLayers = {
@@ -191,8 +343,10 @@ private:
     VkBuffer indexBuffer;
     VkDeviceMemory indexBufferMemory;
     VkDescriptorSetLayout descriptorSetLayout;
-    std::vector<VkBuffer> uniformBuffers;
-    std::vector<VkDeviceMemory> uniformBuffersMemory;
+    // one persistently mapped buffer, every frame in flight owns a region of it
+    VkBuffer uniformBuffer;
+    VkDeviceMemory uniformBufferMemory;
+    FrameAllocator uniformAllocator;
     VkDescriptorPool descriptorPool;
     std::vector<VkDescriptorSet> descriptorSets;
     VkImage textureImage;
@@ -207,6 +361,10 @@ private:
     VkImageView depthImageView;
     std::vector<Vertex> vertices;
     std::vector<uint32_t> indicies;
+    uint32_t indexCount;
+    std::vector<uint8_t> vertexData; // vertices encoded in VERTEX_LAYOUT
+    MeshBounds meshBounds;
+    MeshCache meshCache;
     uint32_t mipLevels;
     VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_1_BIT;
     VkImage colorImage;
@@ -267,6 +425,7 @@ private:
             loadModel();
             createVertexBuffer();
             createIndexBuffer();
+            meshCache.close(); // already copied into the staging buffers
             createUniformBuffers();
             createDescriptorPool();
             createDescriptorSets();
@@ -297,10 +456,9 @@ private:
         vkDestroyImage(device, textureImage, nullptr);
         vkFreeMemory(device, textureImageMemory, nullptr);
         // Uniform /buffers clean
-        for(size_t i=0; i<MAX_FRAMES_IN_FLIGHT; i++){
-            vkDestroyBuffer(device, uniformBuffers[i], nullptr);
-            vkFreeMemory(device, uniformBuffersMemory[i], nullptr);
-        }
+        uniformAllocator.destroy();
+        vkDestroyBuffer(device, uniformBuffer, nullptr);
+        vkFreeMemory(device, uniformBufferMemory, nullptr);
         vkDestroyDescriptorPool(device, descriptorPool, nullptr);
         vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
         // buffer clean
@@ -796,8 +954,8 @@ private:
         VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
 
         // vertex data handling
-        auto bindingDescription = Vertex::getBindingDescripton();
-        auto attributeDesccriptions = Vertex::getAttributeDescriptons();
+        auto bindingDescription = getVertexBindingDescription(VERTEX_LAYOUT);
+        auto attributeDesccriptions = getVertexAttributeDescriptions(VERTEX_LAYOUT);
 
         VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
         vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -1105,7 +1263,7 @@ private:
         }
     }
 
-    void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex){
+    void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t uniformOffset){
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
         beginInfo.flags = 0;
@@ -1140,7 +1298,7 @@ private:
         // index buffer
         vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
 
-        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[currentFrame], 0, nullptr);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[currentFrame], 1, &uniformOffset);
 
         // viewport to framebuffer mapping
         VkViewport viewport{};
@@ -1159,7 +1317,7 @@ private:
         vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
         //vkCmdDraw(commandBuffer, static_cast<uint32_t>(vertices.size()), 1, 0, 0);
-        vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(indicies.size()), 1, 0, 0, 0);
+        vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
 
         vkCmdEndRenderPass(commandBuffer);
 
@@ -1195,6 +1353,8 @@ private:
 
     void drawFrame(){
         vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+        // the GPU is done with this frame's uniform region
+        uniformAllocator.beginFrame(static_cast<uint32_t>(currentFrame));
 
         uint32_t imageIndex;
         VkResult result = vkAcquireNextImageKHR(device, swapChain, UINT64_MAX, imageAvaibleSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
@@ -1208,10 +1368,11 @@ private:
 
         vkResetFences(device, 1, &inFlightFences[currentFrame]);
 
-        vkResetCommandBuffer(commandBuffers[currentFrame], 0);
-        recordCommandBuffer(commandBuffers[currentFrame], imageIndex);
+        // offsets are baked into the command buffer, so the uniforms are allocated first
+        uint32_t uniformOffset = updateUniformBuffer();
 
-        updateUniformBuffer(currentFrame);
+        vkResetCommandBuffer(commandBuffers[currentFrame], 0);
+        recordCommandBuffer(commandBuffers[currentFrame], imageIndex, uniformOffset);
 
         VkSubmitInfo submitInfo{};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -1369,13 +1530,15 @@ private:
     }
 
     void createVertexBuffer(){
-        VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
+        // straight out of the mapped cache when we have one
+        const void* source = meshCache.isOpen() ? meshCache.vertexData() : vertexData.data();
+        VkDeviceSize bufferSize = meshCache.isOpen() ? meshCache.vertexBytes() : vertexData.size();
 
         size_t offset = getNewSetupStagingBuffer(bufferSize);
 
         void* data;
         vkMapMemory(device, setupStagingBufferMemory[offset], 0, bufferSize, 0, &data);
-        memcpy(data, vertices.data(), (size_t)bufferSize);
+        memcpy(data, source, (size_t)bufferSize);
         vkUnmapMemory(device, setupStagingBufferMemory[offset]);
 
         createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferMemory);
@@ -1384,13 +1547,14 @@ private:
     }
 
     void createIndexBuffer(){
-        VkDeviceSize bufferSize = sizeof(indicies[0]) * indicies.size();
+        const void* source = meshCache.isOpen() ? meshCache.indexData() : indicies.data();
+        VkDeviceSize bufferSize = meshCache.isOpen() ? meshCache.indexBytes() : sizeof(indicies[0]) * indicies.size();
 
         size_t offset = getNewSetupStagingBuffer(bufferSize);
 
         void* data;
         vkMapMemory(device, setupStagingBufferMemory[offset], 0, bufferSize, 0, &data);
-        memcpy(data, indicies.data(), (size_t)bufferSize);
+        memcpy(data, source, (size_t)bufferSize);
         vkUnmapMemory(device, setupStagingBufferMemory[offset]);
 
         createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferMemory);
@@ -1401,7 +1565,7 @@ private:
     void createDescriptorSetLayout(){
         VkDescriptorSetLayoutBinding uboLayoutBinding{};
         uboLayoutBinding.binding = 0;
-        uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
         uboLayoutBinding.descriptorCount = 1;
         uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
         uboLayoutBinding.pImmutableSamplers = nullptr;
@@ -1425,40 +1589,39 @@ private:
     }
 
     void createUniformBuffers(){
-        VkDeviceSize bufferSize = sizeof(UniformBufferObject);
-
-        uniformBuffers.resize(MAX_FRAMES_IN_FLIGHT);
-        uniformBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        VkDeviceSize alignment = properties.limits.minUniformBufferOffsetAlignment;
 
-        for(size_t i=0; i < MAX_FRAMES_IN_FLIGHT; i++){
-            createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uniformBuffers[i], uniformBuffersMemory[i]);
-        }
+        VkDeviceSize bufferSize = FrameAllocator::getBufferSize(UNIFORM_FRAME_SIZE, MAX_FRAMES_IN_FLIGHT, alignment);
+        createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uniformBuffer, uniformBufferMemory);
+        uniformAllocator.init(device, uniformBufferMemory, UNIFORM_FRAME_SIZE, MAX_FRAMES_IN_FLIGHT, alignment);
     }
 
-    void updateUniformBuffer(uint32_t currentImage){
+    // writes this frame's uniforms and returns their dynamic offset
+    uint32_t updateUniformBuffer(){
         static auto startTime = std::chrono::high_resolution_clock::now();
 
         auto currentTime = std::chrono::high_resolution_clock::now();
         float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
 
         UniformBufferObject ubo{};
-        ubo.model = glm::rotate(glm::mat4(1.0f), time*glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        // packed vertices are decoded by folding the inverse quantization into the model matrix
+        ubo.model = glm::rotate(glm::mat4(1.0f), time*glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f)) * getPositionDecode(VERTEX_LAYOUT, meshBounds);
+        ubo.uvTransform = getTexCoordDecode(VERTEX_LAYOUT, meshBounds);
         ubo.view = glm::lookAt(glm::vec3(2.0f,2.0f,2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
         ubo.proj = glm::perspective(glm::radians(45.0f), swapChainExtent.width / (float) swapChainExtent.height, 0.1f, 10.0f);
 
         // openGL to Vulkan fix
         ubo.proj[1][1] *= -1;
 
-        void* data;
-        vkMapMemory(device, uniformBuffersMemory[currentImage], 0, sizeof(ubo), 0, &data);
-        memcpy(data, &ubo, sizeof(ubo));
-        vkUnmapMemory(device, uniformBuffersMemory[currentImage]);
+        return uniformAllocator.push(ubo).offset;
     }
 
     void createDescriptorPool(){
         std::array<VkDescriptorPoolSize, 2> poolSizes{};
 
-        poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
         poolSizes[0].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
         poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         poolSizes[1].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
@@ -1490,7 +1653,8 @@ private:
 
         for(size_t i=0; i<MAX_FRAMES_IN_FLIGHT; i++){
             VkDescriptorBufferInfo bufferInfo{};
-            bufferInfo.buffer = uniformBuffers[i];
+            // the dynamic offset picks the frame region and the allocation within it
+            bufferInfo.buffer = uniformBuffer;
             bufferInfo.offset = 0;
             bufferInfo.range = sizeof(UniformBufferObject);
 
@@ -1505,7 +1669,7 @@ private:
             descriptorWrites[0].dstSet = descriptorSets[i];
             descriptorWrites[0].dstBinding = 0;
             descriptorWrites[0].dstArrayElement = 0;
-            descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
             descriptorWrites[0].descriptorCount = 1;
             descriptorWrites[0].pBufferInfo = &bufferInfo;
             descriptorWrites[0].pImageInfo = nullptr;
@@ -1858,42 +2022,96 @@ private:
     }
 
     void loadModel(){
+        // a cache written from the same source contents skips parsing entirely
+        uint64_t sourceHash = hashFile(MODEL_PATH);
+        uint32_t vertexStride = getVertexStride(VERTEX_LAYOUT);
+        if(meshCache.open(MODEL_CACHE_PATH, sourceHash, static_cast<uint32_t>(VERTEX_LAYOUT), vertexStride)){
+            indexCount = static_cast<uint32_t>(meshCache.getHeader().indexCount);
+            meshBounds = meshCache.getHeader().bounds;
+            return;
+        }
+
+        parseModel();
+        indexCount = static_cast<uint32_t>(indicies.size());
+
+        meshBounds = computeMeshBounds(vertices);
+        QuantizationError error = encodeVertices(vertices, VERTEX_LAYOUT, meshBounds, vertexData);
+        glm::vec3 boundsSize = glm::make_vec3(meshBounds.positionMax) - glm::make_vec3(meshBounds.positionMin);
+        std::cout << "vertex format: " << vertexStride << " bytes per vertex (" << sizeof(Vertex) << " unpacked), "
+            << "position error max " << error.maxPosition << " rms " << error.rmsPosition
+            << " (bounds diagonal " << glm::length(boundsSize) << "), color error max " << error.maxColor
+            << ", uv error max " << error.maxTexCoord << '\n';
+
+        // not being able to write the cache only costs the next startup
+        if(!writeMeshCache(MODEL_CACHE_PATH, sourceHash, static_cast<uint32_t>(VERTEX_LAYOUT), vertexData.data(), vertexStride, vertices.size(), indicies.data(), indicies.size(), meshBounds)){
+            std::cerr << "failed to write mesh cache " << MODEL_CACHE_PATH << std::endl;
+        }
+    }
+
+    void parseModel(){
         tinyobj::attrib_t attrib;
         std::vector<tinyobj::shape_t> shapes;
         std::vector<tinyobj::material_t> materials;
         std::string warn, err;
 
-        if(!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, MODEL_PATH.c_str())){
+        if(!tinyobj::LoadObjParallel(&attrib, &shapes, &materials, &warn, &err, MODEL_PATH.c_str())){
             throw std::runtime_error(warn+err);
         }
 
-        std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+        size_t totalIndices = 0;
+        for(const auto& shape : shapes){
+            totalIndices += shape.mesh.indices.size();
+        }
 
+        // one vertex per index, welded afterwards
+        std::vector<Vertex> expanded;
+        expanded.reserve(totalIndices);
         for(const auto& shape : shapes){
             for(const auto& index : shape.mesh.indices){
                 Vertex vertex{};
 
-                vertex.pos = {
+                // + 0.0f turns -0.0f into 0.0f, welding compares raw bytes
+                vertex.pos = glm::vec3{
                     attrib.vertices[3 * index.vertex_index + 0],
                     attrib.vertices[3 * index.vertex_index + 1],
                     attrib.vertices[3 * index.vertex_index + 2]
-                };
+                } + 0.0f;
 
-                vertex.texCoord = {
+                vertex.texCoord = glm::vec2{
                     attrib.texcoords[2 * index.texcoord_index + 0],
                     1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-                };
+                } + 0.0f;
 
                 vertex.color = {1.0f, 1.0f, 1.0f};
 
-                if(uniqueVertices.count(vertex) == 0){
-                    uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                    vertices.push_back(vertex);
-                }
-
-                indicies.push_back(uniqueVertices[vertex]);
+                expanded.push_back(vertex);
             }
         }
+
+        weld::weldVertices(expanded.data(), expanded.size(), vertices, indicies, 0);
+
+        optimizeModel();
+    }
+
+    // triangle order for the post-transform cache and overdraw, vertex order for fetch locality
+    void optimizeModel(){
+        if(indicies.empty()){
+            return;
+        }
+
+        auto before = meshopt::analyzeVertexCache(indicies.data(), indicies.size(), vertices.size());
+
+        meshopt::optimizeVertexCache(indicies.data(), indicies.data(), indicies.size(), vertices.size());
+        meshopt::optimizeOverdraw(indicies.data(), indicies.data(), indicies.size(), &vertices[0].pos.x, vertices.size(), sizeof(Vertex));
+
+        std::vector<Vertex> fetchOrdered(vertices.size());
+        size_t usedVertices = meshopt::optimizeVertexFetch(fetchOrdered.data(), indicies.data(), indicies.size(), vertices.data(), vertices.size(), sizeof(Vertex));
+        fetchOrdered.resize(usedVertices);
+        vertices.swap(fetchOrdered);
+
+        auto after = meshopt::analyzeVertexCache(indicies.data(), indicies.size(), vertices.size());
+        std::cout << "model vertex cache: ACMR " << before.acmr << " -> " << after.acmr
+            << ", ATVR " << before.atvr << " -> " << after.atvr << '\n';
     }
 
     void generateMipMaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels){
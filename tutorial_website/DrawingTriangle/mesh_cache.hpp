@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hash.hpp"
+
+// Binary mesh cache, deduplicated vertices and 32 bit indices ready to be copied into GPU buffers.
+// Layout: MeshCacheHeader | vertices (at vertexOffset) | indices (at indexOffset)
+// Bump MESH_CACHE_VERSION whenever the vertex layout or the processing done before writing changes.
+constexpr uint32_t MESH_CACHE_VERSION = 4;
+constexpr char MESH_CACHE_MAGIC[4] = {'V', 'K', 'M', 'C'};
+
+// axis aligned bounds of positions and texture coordinates, quantized layouts are relative to these
+struct MeshBounds{
+    float positionMin[3];
+    float positionMax[3];
+    float texCoordMin[2];
+    float texCoordMax[2];
+};
+
+struct MeshCacheHeader{
+    char magic[4];
+    uint32_t version;
+    uint32_t vertexLayout;  // application defined id of the vertex format
+    uint32_t vertexSize;    // stride of that format when the cache was written
+    uint32_t indexSize;
+    uint64_t sourceHash;    // hash of the source file contents
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    MeshBounds bounds;
+};
+
+// read only mapping of a file, unmapped on destruction
+class MappedFile{
+public:
+    MappedFile() = default;
+    ~MappedFile(){ close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path){
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0){
+            return false;
+        }
+        struct stat fileStat;
+        if(fstat(fd, &fileStat) != 0 || fileStat.st_size == 0){
+            ::close(fd);
+            return false;
+        }
+        void* mapping = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // the mapping keeps its own reference
+        if(mapping == MAP_FAILED){
+            return false;
+        }
+        data = static_cast<const uint8_t*>(mapping);
+        size = static_cast<size_t>(fileStat.st_size);
+        return true;
+    }
+
+    void close(){
+        if(data != nullptr){
+            munmap(const_cast<uint8_t*>(data), size);
+            data = nullptr;
+            size = 0;
+        }
+    }
+
+    bool isOpen() const { return data != nullptr; }
+    const uint8_t* getData() const { return data; }
+    size_t getSize() const { return size; }
+
+private:
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+inline uint64_t hashFile(const std::string& path){
+    MappedFile file;
+    if(!file.open(path)){
+        throw std::runtime_error("failed to open " + path);
+    }
+    return hash::hashBytes(file.getData(), file.getSize());
+}
+
+// mapped cache file, vertex and index data point straight into the mapping
+class MeshCache{
+public:
+    // false when the cache is missing, corrupt, from another version or from other source contents
+    bool open(const std::string& path, uint64_t sourceHash, uint32_t vertexLayout, uint32_t vertexSize){
+        if(!file.open(path)){
+            return false;
+        }
+
+        if(file.getSize() < sizeof(MeshCacheHeader)){
+            file.close();
+            return false;
+        }
+        memcpy(&header, file.getData(), sizeof(header));
+
+        bool valid = memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) == 0 &&
+            header.version == MESH_CACHE_VERSION &&
+            header.vertexLayout == vertexLayout &&
+            header.vertexSize == vertexSize &&
+            header.indexSize == sizeof(uint32_t) &&
+            header.sourceHash == sourceHash &&
+            fitsInFile(header.vertexOffset, header.vertexCount, vertexSize) &&
+            fitsInFile(header.indexOffset, header.indexCount, sizeof(uint32_t));
+        if(!valid){
+            file.close();
+        }
+        return valid;
+    }
+
+    void close(){ file.close(); }
+    bool isOpen() const { return file.isOpen(); }
+
+    const MeshCacheHeader& getHeader() const { return header; }
+    const void* vertexData() const { return file.getData() + header.vertexOffset; }
+    const void* indexData() const { return file.getData() + header.indexOffset; }
+    size_t vertexBytes() const { return header.vertexCount * header.vertexSize; }
+    size_t indexBytes() const { return header.indexCount * header.indexSize; }
+
+private:
+    MappedFile file;
+    MeshCacheHeader header{};
+
+    // the header comes from disk, so offset + count * elementSize is checked without computing it, it could overflow
+    bool fitsInFile(uint64_t offset, uint64_t count, uint64_t elementSize) const{
+        uint64_t size = file.getSize();
+        return elementSize > 0 && offset <= size && count <= (size - offset) / elementSize;
+    }
+};
+
+// written to a temporary file and renamed, so readers never see a half written cache
+inline bool writeMeshCache(const std::string& path, uint64_t sourceHash,
+    uint32_t vertexLayout, const void* vertices, uint32_t vertexSize, uint64_t vertexCount,
+    const uint32_t* indices, uint64_t indexCount, const MeshBounds& bounds)
+{
+    auto alignUp = [](uint64_t value){ return (value + 15) & ~uint64_t(15); };
+
+    MeshCacheHeader header{};
+    memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+    header.version = MESH_CACHE_VERSION;
+    header.vertexLayout = vertexLayout;
+    header.vertexSize = vertexSize;
+    header.indexSize = sizeof(uint32_t);
+    header.sourceHash = sourceHash;
+    header.vertexCount = vertexCount;
+    header.indexCount = indexCount;
+    header.vertexOffset = alignUp(sizeof(MeshCacheHeader));
+    header.indexOffset = alignUp(header.vertexOffset + vertexCount * vertexSize);
+    header.bounds = bounds;
+
+    std::string tmpPath = path + ".tmp";
+    FILE* out = fopen(tmpPath.c_str(), "wb");
+    if(out == nullptr){
+        return false;
+    }
+
+    const uint8_t padding[16] = {};
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+    ok = ok && fwrite(padding, 1, header.vertexOffset - sizeof(header), out) == header.vertexOffset - sizeof(header);
+    ok = ok && fwrite(vertices, vertexSize, vertexCount, out) == vertexCount;
+    uint64_t vertexEnd = header.vertexOffset + vertexCount * vertexSize;
+    ok = ok && fwrite(padding, 1, header.indexOffset - vertexEnd, out) == header.indexOffset - vertexEnd;
+    ok = ok && fwrite(indices, sizeof(uint32_t), indexCount, out) == indexCount;
+    ok = (fclose(out) == 0) && ok;
+
+    if(!ok || rename(tmpPath.c_str(), path.c_str()) != 0){
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
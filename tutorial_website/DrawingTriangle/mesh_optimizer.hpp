@@ -0,0 +1,354 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Index buffer optimizations for indexed triangle lists:
+//  optimizeVertexCache  - triangle order for post-transform cache reuse (Forsyth)
+//  optimizeOverdraw     - cluster order for early depth rejection (Tipsify style, keeps most of the cache reuse)
+//  optimizeVertexFetch  - vertex order matching first use, so vertex fetches walk memory linearly
+// and a FIFO cache simulator to measure the result without a GPU.
+namespace meshopt {
+
+    struct VertexCacheStats{
+        size_t vertexTransforms;    // cache misses, i.e. vertex shader invocations
+        float acmr;                 // transforms per triangle, 0.5 is ideal for big regular meshes, 3 is worst
+        float atvr;                 // transforms per vertex, 1 is ideal
+    };
+
+    // FIFO cache like most GPUs use for post-transform results
+    inline VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned cacheSize = 16){
+        assert(indexCount % 3 == 0);
+
+        // vertex is cached while fewer than cacheSize misses happened since it was inserted
+        std::vector<size_t> insertedAt(vertexCount, 0);
+        size_t time = cacheSize + 1;
+        size_t misses = 0;
+
+        for(size_t i = 0; i < indexCount; i++){
+            uint32_t vertex = indices[i];
+            assert(vertex < vertexCount);
+            if(time - insertedAt[vertex] > cacheSize){
+                insertedAt[vertex] = time++;
+                misses++;
+            }
+        }
+
+        VertexCacheStats stats{};
+        stats.vertexTransforms = misses;
+        stats.acmr = indexCount == 0 ? 0.0f : float(misses) / float(indexCount / 3);
+        stats.atvr = vertexCount == 0 ? 0.0f : float(misses) / float(vertexCount);
+        return stats;
+    }
+
+    namespace detail {
+
+        constexpr unsigned FORSYTH_CACHE_SIZE = 32;
+        constexpr unsigned FORSYTH_VALENCE_TABLE_SIZE = 32;
+        constexpr uint32_t NO_TRIANGLE = UINT32_MAX;
+
+        // Tom Forsyth, "Linear-Speed Vertex Cache Optimisation"
+        struct ForsythScores{
+            std::array<float, FORSYTH_CACHE_SIZE> cache;
+            std::array<float, FORSYTH_VALENCE_TABLE_SIZE> valence;
+
+            ForsythScores(){
+                const float cacheDecayPower = 1.5f;
+                const float lastTriangleScore = 0.75f;
+                const float valenceBoostScale = 2.0f;
+                const float valenceBoostPower = 0.5f;
+
+                for(unsigned i = 0; i < FORSYTH_CACHE_SIZE; i++){
+                    // the last triangle's vertices get a fixed score, so the next one doesn't just reuse its edge
+                    cache[i] = i < 3 ? lastTriangleScore :
+                        std::pow(1.0f - float(i - 3) / float(FORSYTH_CACHE_SIZE - 3), cacheDecayPower);
+                }
+                valence[0] = 0.0f;
+                for(unsigned i = 1; i < FORSYTH_VALENCE_TABLE_SIZE; i++){
+                    // few remaining triangles, finish the vertex off before it gets evicted
+                    valence[i] = valenceBoostScale * std::pow(float(i), -valenceBoostPower);
+                }
+            }
+
+            float operator()(int cachePosition, uint32_t remaining) const{
+                if(remaining == 0){
+                    return -1.0f;
+                }
+                float score = cachePosition >= 0 ? cache[cachePosition] : 0.0f;
+                return score + valence[std::min<uint32_t>(remaining, FORSYTH_VALENCE_TABLE_SIZE - 1)];
+            }
+        };
+
+    }
+
+    // dst may alias indices
+    inline void optimizeVertexCache(uint32_t* dst, const uint32_t* indices, size_t indexCount, size_t vertexCount){
+        using namespace detail;
+        assert(indexCount % 3 == 0);
+
+        static const ForsythScores vertexScore;
+        const std::vector<uint32_t> source(indices, indices + indexCount);
+        const size_t triangleCount = indexCount / 3;
+
+        // triangles using each vertex, live ones are kept at the front of every list
+        std::vector<uint32_t> remaining(vertexCount, 0);
+        for(uint32_t vertex : source){
+            assert(vertex < vertexCount);
+            remaining[vertex]++;
+        }
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+        for(size_t v = 0; v < vertexCount; v++){
+            adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remaining[v];
+        }
+        std::vector<uint32_t> adjacency(indexCount);
+        {
+            std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for(size_t i = 0; i < indexCount; i++){
+                adjacency[cursor[source[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        std::vector<int> cachePosition(vertexCount, -1);
+        std::vector<float> vertexScores(vertexCount);
+        for(size_t v = 0; v < vertexCount; v++){
+            vertexScores[v] = vertexScore(-1, remaining[v]);
+        }
+
+        std::vector<float> triangleScores(triangleCount);
+        std::vector<bool> emitted(triangleCount, false);
+        uint32_t best = NO_TRIANGLE;
+        for(size_t t = 0; t < triangleCount; t++){
+            triangleScores[t] = vertexScores[source[3 * t]] + vertexScores[source[3 * t + 1]] + vertexScores[source[3 * t + 2]];
+            if(best == NO_TRIANGLE || triangleScores[t] > triangleScores[best]){
+                best = static_cast<uint32_t>(t);
+            }
+        }
+
+        std::array<uint32_t, FORSYTH_CACHE_SIZE + 3> cache;
+        std::array<uint32_t, FORSYTH_CACHE_SIZE + 3> newCache;
+        size_t cacheCount = 0;
+        size_t nextUnemitted = 0;   // fallback when no cached vertex has triangles left
+
+        for(size_t out = 0; out < triangleCount; out++){
+            if(best == NO_TRIANGLE){
+                while(emitted[nextUnemitted]){
+                    nextUnemitted++;
+                }
+                best = static_cast<uint32_t>(nextUnemitted);
+            }
+
+            const uint32_t* triangle = &source[3 * best];
+            memcpy(&dst[3 * out], triangle, 3 * sizeof(uint32_t));
+            emitted[best] = true;
+
+            // take the triangle out of its vertices' live lists
+            for(unsigned corner = 0; corner < 3; corner++){
+                uint32_t vertex = triangle[corner];
+                uint32_t* list = &adjacency[adjacencyOffsets[vertex]];
+                uint32_t last = remaining[vertex] - 1;
+                for(uint32_t i = 0; i <= last; i++){
+                    if(list[i] == best){
+                        std::swap(list[i], list[last]);
+                        break;
+                    }
+                }
+                remaining[vertex]--;
+            }
+
+            // LRU update, the triangle's vertices move to the front
+            size_t newCount = 0;
+            for(unsigned corner = 0; corner < 3; corner++){
+                uint32_t vertex = triangle[corner];
+                if(std::find(newCache.begin(), newCache.begin() + newCount, vertex) == newCache.begin() + newCount){
+                    newCache[newCount++] = vertex;
+                }
+            }
+            for(size_t i = 0; i < cacheCount; i++){
+                uint32_t vertex = cache[i];
+                if(vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2]){
+                    newCache[newCount++] = vertex;
+                }
+            }
+
+            // rescore everything that moved, including what just fell out of the cache
+            for(size_t i = 0; i < newCount; i++){
+                uint32_t vertex = newCache[i];
+                cachePosition[vertex] = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+                float score = vertexScore(cachePosition[vertex], remaining[vertex]);
+                float delta = score - vertexScores[vertex];
+                vertexScores[vertex] = score;
+
+                const uint32_t* list = &adjacency[adjacencyOffsets[vertex]];
+                for(uint32_t j = 0; j < remaining[vertex]; j++){
+                    triangleScores[list[j]] += delta;
+                }
+            }
+
+            cacheCount = std::min<size_t>(newCount, FORSYTH_CACHE_SIZE);
+            std::copy(newCache.begin(), newCache.begin() + cacheCount, cache.begin());
+
+            // next triangle is the best one touching the cache
+            best = NO_TRIANGLE;
+            for(size_t i = 0; i < cacheCount; i++){
+                uint32_t vertex = cache[i];
+                const uint32_t* list = &adjacency[adjacencyOffsets[vertex]];
+                for(uint32_t j = 0; j < remaining[vertex]; j++){
+                    if(best == NO_TRIANGLE || triangleScores[list[j]] > triangleScores[best]){
+                        best = list[j];
+                    }
+                }
+            }
+        }
+    }
+
+    // Reorders clusters of an already cache optimized index buffer so that triangles facing away from the
+    // mesh center come first and occlude the rest. The buffer is split where the cache would be cold anyway
+    // and, within those, wherever a cluster's ACMR is already within `threshold` of the whole mesh.
+    // positions are 3 floats every positionStride bytes, dst may alias indices
+    inline void optimizeOverdraw(uint32_t* dst, const uint32_t* indices, size_t indexCount,
+        const float* positions, size_t vertexCount, size_t positionStride, float threshold = 1.05f, unsigned cacheSize = 16)
+    {
+        assert(indexCount % 3 == 0);
+        const std::vector<uint32_t> source(indices, indices + indexCount);
+        const size_t triangleCount = indexCount / 3;
+        if(triangleCount == 0){
+            return;
+        }
+
+        const float meshAcmr = analyzeVertexCache(source.data(), indexCount, vertexCount, cacheSize).acmr;
+
+        // cluster boundaries, each cluster simulated from a cold cache
+        std::vector<size_t> clusterStarts;
+        {
+            std::vector<size_t> insertedAt(vertexCount, 0);
+            size_t time = cacheSize + 1;
+            size_t clusterMisses = 0;
+            size_t clusterStart = 0;
+
+            for(size_t t = 0; t < triangleCount; t++){
+                unsigned misses = 0;
+                for(unsigned corner = 0; corner < 3; corner++){
+                    uint32_t vertex = source[3 * t + corner];
+                    if(time - insertedAt[vertex] > cacheSize){
+                        insertedAt[vertex] = time++;
+                        misses++;
+                    }
+                }
+
+                // hard boundary, nothing of this triangle was cached
+                if(t == 0 || (misses == 3 && t != clusterStart)){
+                    clusterStarts.push_back(t);
+                    clusterStart = t;
+                    clusterMisses = 0;
+                }
+                clusterMisses += misses;
+
+                // soft boundary, the cluster is good enough on its own
+                float clusterAcmr = float(clusterMisses) / float(t - clusterStart + 1);
+                if(clusterAcmr <= meshAcmr * threshold && t + 1 < triangleCount){
+                    clusterStarts.push_back(t + 1);
+                    clusterStart = t + 1;
+                    clusterMisses = 0;
+                    time += cacheSize + 1; // cold cache for the next cluster
+                }
+            }
+        }
+        clusterStarts.push_back(triangleCount);
+        const size_t clusterCount = clusterStarts.size() - 1;
+
+        auto position = [&](uint32_t vertex){
+            return reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + vertex * positionStride);
+        };
+
+        // area weighted centroid and normal of every cluster
+        std::vector<std::array<float, 6>> clusterData(clusterCount);
+        float meshCentroid[3] = {0.0f, 0.0f, 0.0f};
+        float meshArea = 0.0f;
+        for(size_t c = 0; c < clusterCount; c++){
+            float centroid[3] = {0.0f, 0.0f, 0.0f};
+            float normal[3] = {0.0f, 0.0f, 0.0f};
+            float area = 0.0f;
+
+            for(size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++){
+                const float* p0 = position(source[3 * t]);
+                const float* p1 = position(source[3 * t + 1]);
+                const float* p2 = position(source[3 * t + 2]);
+
+                float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+                float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+                float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+                float triangleArea = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+                for(unsigned k = 0; k < 3; k++){
+                    centroid[k] += (p0[k] + p1[k] + p2[k]) / 3.0f * triangleArea;
+                    normal[k] += n[k];
+                }
+                area += triangleArea;
+            }
+
+            float invArea = area == 0.0f ? 0.0f : 1.0f / area;
+            float normalLength = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            float invNormal = normalLength == 0.0f ? 0.0f : 1.0f / normalLength;
+            for(unsigned k = 0; k < 3; k++){
+                meshCentroid[k] += centroid[k];
+                clusterData[c][k] = centroid[k] * invArea;
+                clusterData[c][3 + k] = normal[k] * invNormal;
+            }
+            meshArea += area;
+        }
+        for(unsigned k = 0; k < 3; k++){
+            meshCentroid[k] = meshArea == 0.0f ? 0.0f : meshCentroid[k] / meshArea;
+        }
+
+        // outward facing clusters far from the center first
+        std::vector<float> sortKeys(clusterCount);
+        for(size_t c = 0; c < clusterCount; c++){
+            float key = 0.0f;
+            for(unsigned k = 0; k < 3; k++){
+                key += (clusterData[c][k] - meshCentroid[k]) * clusterData[c][3 + k];
+            }
+            sortKeys[c] = key;
+        }
+        std::vector<size_t> order(clusterCount);
+        for(size_t c = 0; c < clusterCount; c++){
+            order[c] = c;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b){ return sortKeys[a] > sortKeys[b]; });
+
+        size_t out = 0;
+        for(size_t c : order){
+            size_t begin = 3 * clusterStarts[c];
+            size_t end = 3 * clusterStarts[c + 1];
+            std::copy(source.begin() + begin, source.begin() + end, dst + out);
+            out += end - begin;
+        }
+    }
+
+    // Copies vertices into dstVertices in order of first use and rewrites indices to match.
+    // Unreferenced vertices are dropped, returns the new vertex count. dstVertices must not alias vertices.
+    inline size_t optimizeVertexFetch(void* dstVertices, uint32_t* indices, size_t indexCount,
+        const void* vertices, size_t vertexCount, size_t vertexSize)
+    {
+        constexpr uint32_t UNUSED = UINT32_MAX;
+        std::vector<uint32_t> remap(vertexCount, UNUSED);
+        uint32_t next = 0;
+
+        for(size_t i = 0; i < indexCount; i++){
+            uint32_t vertex = indices[i];
+            assert(vertex < vertexCount);
+            if(remap[vertex] == UNUSED){
+                memcpy(static_cast<char*>(dstVertices) + next * vertexSize, static_cast<const char*>(vertices) + vertex * vertexSize, vertexSize);
+                remap[vertex] = next++;
+            }
+            indices[i] = remap[vertex];
+        }
+        return next;
+    }
+
+}
@@ -4,6 +4,7 @@ layout(binding = 0) uniform UniformBufferObject {
     mat4 model;
     mat4 view;
     mat4 proj;
+    vec4 uvTransform;
 } ubo;
 
 layout(location = 0) in vec3 inPosition;
@@ -16,5 +17,6 @@ layout(location = 1) out vec2 fragTexCoord;
 void main(){
     gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
     fragColor = inColor;
-    fragTexCoord = inTexCoord;
+    // packed uvs are relative to the model's uv bounds
+    fragTexCoord = inTexCoord * ubo.uvTransform.xy + ubo.uvTransform.zw;
 }
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "hash.hpp"
+
+// Vertex welding, collapses identical vertices into one and produces the index buffer referencing them.
+// Vertices are compared and hashed by their raw bytes, so canonicalize -0.0f before welding if it matters.
+// Unique vertices come out in order of first occurrence, regardless of the number of threads used.
+namespace weld {
+
+    // open addressing with linear probing, slots only reference keys stored elsewhere
+    template<typename T>
+    class WeldTable{
+    public:
+        // sized for `maxKeys` up front at a load factor of at most 0.5, so it never has to grow
+        explicit WeldTable(size_t maxKeys){
+            size_t capacity = 16;
+            while(capacity < maxKeys * 2){
+                capacity *= 2;
+            }
+            slots.assign(capacity, Slot{});
+            mask = capacity - 1;
+        }
+
+        // returns the reference of an equal key, or inserts `newRef` and returns it
+        // keys[ref] has to be valid for every reference inserted so far
+        uint32_t findOrInsert(const T& key, uint64_t keyHash, const T* keys, uint32_t newRef){
+            const uint32_t tag = static_cast<uint32_t>(keyHash >> 32);
+            for(size_t i = keyHash & mask;; i = (i + 1) & mask){
+                Slot& slot = slots[i];
+                if(slot.ref == EMPTY){
+                    slot.tag = tag;
+                    slot.ref = newRef;
+                    return newRef;
+                }
+                if(slot.tag == tag && memcmp(&keys[slot.ref], &key, sizeof(T)) == 0){
+                    return slot.ref;
+                }
+            }
+        }
+
+    private:
+        static constexpr uint32_t EMPTY = UINT32_MAX;
+
+        struct Slot{
+            uint32_t tag = 0;       // upper hash bits, skips most key compares
+            uint32_t ref = EMPTY;
+        };
+
+        std::vector<Slot> slots;
+        size_t mask;
+    };
+
+    template<typename Fn>
+    void parallelFor(unsigned threadCount, Fn fn){
+        std::vector<std::thread> workers;
+        for(unsigned t = 1; t < threadCount; t++){
+            workers.emplace_back(fn, t);
+        }
+        fn(0u);
+        for(auto& worker : workers){
+            worker.join();
+        }
+    }
+
+    template<typename T>
+    void weldSerial(const T* input, size_t count, std::vector<T>& vertices, std::vector<uint32_t>& indices){
+        WeldTable<T> table(count);
+        const uint32_t base = static_cast<uint32_t>(vertices.size());
+        vertices.reserve(vertices.size() + count); // keeps vertices.data() stable below
+        const size_t indexBase = indices.size();
+        indices.resize(indexBase + count);
+
+        for(size_t i = 0; i < count; i++){
+            uint64_t keyHash = hash::hashBytes(&input[i], sizeof(T));
+            uint32_t next = static_cast<uint32_t>(vertices.size()) - base;
+            uint32_t ref = table.findOrInsert(input[i], keyHash, vertices.data() + base, next);
+            if(ref == next){
+                vertices.push_back(input[i]);
+            }
+            indices[indexBase + i] = base + ref;
+        }
+    }
+
+    // every thread hashes its own range and splits it by the top hash bits into one list per shard,
+    // then each shard is deduplicated by one thread, visiting inputs in increasing order so the first
+    // occurrence wins like in the serial version. Output ids are assigned with a prefix sum.
+    template<typename T>
+    void weldParallel(const T* input, size_t count, std::vector<T>& vertices, std::vector<uint32_t>& indices, unsigned threadCount){
+        unsigned shardBits = 0;
+        while((1u << shardBits) < threadCount){
+            shardBits++;
+        }
+        const unsigned shardCount = 1u << shardBits;
+        auto rangeBegin = [&](unsigned t){ return count * t / threadCount; };
+
+        std::vector<uint64_t> hashes(count);
+        std::vector<std::vector<std::vector<uint32_t>>> shardInputs(threadCount, std::vector<std::vector<uint32_t>>(shardCount));
+        parallelFor(threadCount, [&](unsigned t){
+            for(auto& list : shardInputs[t]){
+                list.reserve((rangeBegin(t + 1) - rangeBegin(t)) / shardCount + 16);
+            }
+            for(size_t i = rangeBegin(t); i < rangeBegin(t + 1); i++){
+                hashes[i] = hash::hashBytes(&input[i], sizeof(T));
+                unsigned shard = shardBits == 0 ? 0 : static_cast<unsigned>(hashes[i] >> (64 - shardBits));
+                shardInputs[t][shard].push_back(static_cast<uint32_t>(i));
+            }
+        });
+
+        // first[i] = input index of the first vertex equal to input[i]
+        std::vector<uint32_t> first(count);
+        parallelFor(threadCount, [&](unsigned t){
+            for(unsigned shard = t; shard < shardCount; shard += threadCount){
+                size_t shardSize = 0;
+                for(unsigned source = 0; source < threadCount; source++){
+                    shardSize += shardInputs[source][shard].size();
+                }
+                WeldTable<T> table(shardSize);
+                for(unsigned source = 0; source < threadCount; source++){
+                    for(uint32_t i : shardInputs[source][shard]){
+                        first[i] = table.findOrInsert(input[i], hashes[i], input, i);
+                    }
+                }
+            }
+        });
+
+        // number the first occurrences in input order
+        std::vector<uint32_t> uniqueCounts(threadCount + 1, 0);
+        parallelFor(threadCount, [&](unsigned t){
+            uint32_t unique = 0;
+            for(size_t i = rangeBegin(t); i < rangeBegin(t + 1); i++){
+                unique += first[i] == i;
+            }
+            uniqueCounts[t + 1] = unique;
+        });
+        for(unsigned t = 0; t < threadCount; t++){
+            uniqueCounts[t + 1] += uniqueCounts[t];
+        }
+
+        const uint32_t base = static_cast<uint32_t>(vertices.size());
+        vertices.resize(vertices.size() + uniqueCounts[threadCount]);
+        std::vector<uint32_t> vertexId(count);
+        parallelFor(threadCount, [&](unsigned t){
+            uint32_t next = base + uniqueCounts[t];
+            for(size_t i = rangeBegin(t); i < rangeBegin(t + 1); i++){
+                if(first[i] == i){
+                    vertexId[i] = next;
+                    vertices[next++] = input[i];
+                }
+            }
+        });
+
+        const size_t indexBase = indices.size();
+        indices.resize(indexBase + count);
+        parallelFor(threadCount, [&](unsigned t){
+            for(size_t i = rangeBegin(t); i < rangeBegin(t + 1); i++){
+                indices[indexBase + i] = vertexId[first[i]];
+            }
+        });
+    }
+
+    // appends the unique vertices of input[0, count) to `vertices` and one index per input to `indices`,
+    // the i-th appended index references input[i]'s copy
+    // threadCount = 0 picks std::thread::hardware_concurrency()
+    template<typename T>
+    void weldVertices(const T* input, size_t count, std::vector<T>& vertices, std::vector<uint32_t>& indices, unsigned threadCount = 1){
+        static_assert(std::is_trivially_copyable_v<T>, "vertices are hashed and compared as raw bytes");
+
+        if(threadCount == 0){
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        // below this spawning threads costs more than it saves
+        constexpr size_t MIN_VERTICES_PER_THREAD = 1 << 16;
+        threadCount = static_cast<unsigned>(std::min<size_t>(threadCount, std::max<size_t>(1, count / MIN_VERTICES_PER_THREAD)));
+
+        if(threadCount == 1){
+            weldSerial(input, count, vertices, indices);
+        }
+        else{
+            weldParallel(input, count, vertices, indices, threadCount);
+        }
+    }
+
+}